@@ -6,6 +6,34 @@
 #include <pspgum.h>
 #include <pspdebug.h>
 #include <pspkernel.h>
+#include <stdio.h>
+
+// the engine matrix stack of psp_loadrunner, set to 0 to profile the sceGum path it replaces
+#define USE_MATRIX_STACK 1
+#include "../psp_loadrunner/headers/matrix.h"
+
+// draws the meshes as triangle strips built at startup, set to 0 to profile the triangle lists
+#define USE_STRIPS 1
+#include "../psp_loadrunner/headers/strip.h"
+
+// loads the triangle and the square from meshes/*.mesh (converted from the .obj next to them by
+// tools/mesh_convert.c) and draws those, set to 0 to draw the arrays below
+#define USE_MESH_FILES 1
+#include "../psp_loadrunner/headers/mesh.h"
+
+#if USE_MESH_FILES && !USE_MATRIX_STACK
+#error "mesh_draw goes through the matrix stack"
+#endif
+
+// set to 1 to profile the draws: the scene is then submitted SCENE_REPEAT times per frame so the
+// per draw cost shows in the timings printed every PROFILE_FRAMES frames
+#define PROFILE_DRAWS 0
+#if PROFILE_DRAWS
+#define SCENE_REPEAT (100)
+#else
+#define SCENE_REPEAT (1)
+#endif
+#define PROFILE_FRAMES (300)
 
 // PSP Module Info
 PSP_MODULE_INFO("context", 0, 1, 1);
@@ -149,11 +177,28 @@ void endFrame()
 
 void reset_translate(float x, float y, float z) // in 2d it resets the position of zero in the mapto the specified point like (objc2d.trancslate in webgl)
 {
+#if USE_MATRIX_STACK
+    matrix_mode(GU_MODEL);
+    matrix_identity();
+    matrix_translate(x, y, z);
+#else
     sceGumMatrixMode(GU_MODEL);
     sceGumLoadIdentity();
 
     ScePspFVector3 v = {x, y, z};
     sceGumTranslate(&v);
+#endif
+}
+
+// 3d draw with the current matrices
+void draw_array(int prim, int vtype, int count, const void *indices, const void *vertices)
+{
+#if USE_MATRIX_STACK
+    matrix_upload(); // only the matrices that changed since the last draw
+    sceGuDrawArray(prim, vtype, count, indices, vertices);
+#else
+    sceGumDrawArray(prim, vtype, count, indices, vertices);
+#endif
 }
 
 struct Vertex
@@ -201,6 +246,56 @@ struct Vertex *vertex_lists[2] = {triangle, square_indexed};
 short *indices_list[2] = {triangle_indices, square_indices};
 int vertex_count[2] = {3, 6};
 
+// the same meshes as strips, a quad is 4 indices instead of 6 (see tools/stripify.c for offline meshes)
+unsigned short __attribute__((aligned(16))) strip_indices[2][STRIP_MAX_INDICES(2)];
+int strip_count[2];
+
+void build_strips()
+{
+    for (int i = 0; i < sizeof(vertex_lists) / sizeof(vertex_lists[0]); i++)
+        strip_count[i] = strip_build((unsigned short *)indices_list[i], vertex_count[i] / 3, strip_indices[i]);
+
+    sceKernelDcacheWritebackRange(strip_indices, sizeof(strip_indices));
+}
+
+// the same meshes converted offline, vertices already quantized and in strip order
+const char *mesh_paths[2] = {"meshes/triangle.mesh", "meshes/square.mesh"};
+struct Mesh meshes[2];
+
+void load_meshes()
+{
+    for (int i = 0; i < sizeof(mesh_paths) / sizeof(mesh_paths[0]); i++)
+    {
+        if (mesh_load(mesh_paths[i], &meshes[i]) < 0)
+            printf("cannot load %s\n", mesh_paths[i]);
+        else
+            printf("%s: %u bytes loaded in %u us\n", mesh_paths[i], meshes[i].size, meshes[i].load_us);
+    }
+}
+
+// vertices the GE fetches for mesh i
+int mesh_vertices(int i)
+{
+#if USE_MESH_FILES
+    return meshes[i].header ? meshes[i].header->index_count : 0;
+#else
+    return USE_STRIPS ? strip_count[i] : vertex_count[i];
+#endif
+}
+
+// draws mesh i of vertex_lists, as a strip or as its triangle list
+void draw_mesh(int i)
+{
+#if USE_MESH_FILES
+    if (meshes[i].header)
+        mesh_draw(&meshes[i]);
+#elif USE_STRIPS
+    draw_array(GU_TRIANGLE_STRIP, GU_INDEX_16BIT | GU_COLOR_8888 | GU_VERTEX_32BITF | GU_TRANSFORM_3D, strip_count[i], strip_indices[i], vertex_lists[i]);
+#else
+    draw_array(GU_TRIANGLES, GU_INDEX_16BIT | GU_COLOR_8888 | GU_VERTEX_32BITF | GU_TRANSFORM_3D, vertex_count[i], indices_list[i], vertex_lists[i]);
+#endif
+}
+
 int main()
 {
 
@@ -211,6 +306,19 @@ int main()
     initGraphics();
 
     // Initialize Matrices
+#if USE_MATRIX_STACK
+    matrix_init();
+
+    matrix_mode(GU_PROJECTION); // tell is i am in 2d(ortographic matrix) or 3d(perspective matrix)
+    matrix_identity();
+    matrix_ortho(-16.0f / 9.0f, 16.0f / 9.0f, -1.0f, 1.0f, -10.0f, 10.0f);
+
+    matrix_mode(GU_VIEW); // camera transformations
+    matrix_identity();
+
+    matrix_mode(GU_MODEL); // positions of current model
+    matrix_identity();
+#else
     sceGumMatrixMode(GU_PROJECTION); // tell is i am in 2d(ortographic matrix) or 3d(perspective matrix)
     sceGumLoadIdentity();
     sceGumOrtho(-16.0f / 9.0f, 16.0f / 9.0f, -1.0f, 1.0f, -10.0f, 10.0f);
@@ -220,6 +328,18 @@ int main()
 
     sceGumMatrixMode(GU_MODEL); // positions of current model
     sceGumLoadIdentity();
+#endif
+
+#if USE_STRIPS
+    build_strips();
+#endif
+#if USE_MESH_FILES
+    mesh_cull_init();
+    load_meshes();
+#endif
+
+    // cpu time spent submitting draws, printed every PROFILE_FRAMES frames
+    unsigned int frames = 0, draws = 0, draw_us = 0, vertices = 0;
 
     // Main program loop
     while (running)
@@ -233,27 +353,63 @@ int main()
         sceGuClearColor(0xFF000000);
         sceGuClear(GU_COLOR_BUFFER_BIT | GU_DEPTH_BUFFER_BIT);
 
-        reset_translate(0.5f, 0.25f, 0.0f);
-        sceGumDrawArray(GU_TRIANGLES, GU_COLOR_8888 | GU_VERTEX_32BITF | GU_TRANSFORM_3D, 6, NULL, square);
+        unsigned int start = sceKernelGetSystemTimeLow();
 
-        
-        for (int i = 0; i < sizeof(vertex_lists)/ sizeof(vertex_lists[0]); i++)
+        for (int repeat = 0; repeat < SCENE_REPEAT; repeat++)
         {
-            if (i != 0)
-            {
-                reset_translate(-0.5f, 0.0f, 0.0f);
-                sceGumDrawArray(GU_TRIANGLES, GU_INDEX_16BIT | GU_COLOR_8888 | GU_VERTEX_32BITF | GU_TRANSFORM_3D, vertex_count[i], indices_list[i], vertex_lists[i]);
-            }
-            else
+            reset_translate(0.5f, 0.25f, 0.0f);
+#if USE_STRIPS || USE_MESH_FILES
+            draw_mesh(1); // the same square without its 2 duplicated vertices
+            vertices += mesh_vertices(1);
+#else
+            draw_array(GU_TRIANGLES, GU_COLOR_8888 | GU_VERTEX_32BITF | GU_TRANSFORM_3D, 6, NULL, square);
+            vertices += 6;
+#endif
+
+            for (int i = 0; i < sizeof(vertex_lists) / sizeof(vertex_lists[0]); i++)
             {
-                reset_translate(0.0f, -0.5f, 0.0f);
-                sceGumDrawArray(GU_TRIANGLES, GU_INDEX_16BIT | GU_COLOR_8888 | GU_VERTEX_32BITF | GU_TRANSFORM_3D, vertex_count[i], indices_list[i], vertex_lists[i]);
+                if (i != 0)
+                    reset_translate(-0.5f, 0.0f, 0.0f);
+                else
+                    reset_translate(0.0f, -0.5f, 0.0f);
+                draw_mesh(i);
+                vertices += mesh_vertices(i);
             }
+            draws += 3;
+
+#if USE_MESH_FILES
+            // off the right of the screen, the GE skips it after testing its bounding box
+            reset_translate(3.0f, 0.0f, 0.0f);
+            draw_mesh(1);
+            draws++;
+#endif
         }
 
-        endFrame();
+        draw_us += sceKernelGetSystemTimeLow() - start;
+        endFrame(); // the GE is done with the frame, its counters too
+
+        if (++frames == PROFILE_FRAMES)
+        {
+#if USE_MATRIX_STACK
+            printf("matrix stack: %u ns per draw, %u uploads, %u skipped, %u vertices per frame\n",
+                   (unsigned int)(draw_us * 1000ULL / draws), matrix_stats.uploads, matrix_stats.skipped, vertices / PROFILE_FRAMES);
+            matrix_stats.uploads = matrix_stats.skipped = 0;
+#else
+            printf("sceGum: %u ns per draw, %u vertices per frame\n", (unsigned int)(draw_us * 1000ULL / draws), vertices / PROFILE_FRAMES);
+#endif
+#if USE_MESH_FILES && MESH_COUNT_DRAWN
+            printf("meshes: %u submitted, %u skipped by the GE bounding box test\n", mesh_cull_stats.submitted,
+                   mesh_cull_stats.submitted - mesh_cull_stats.drawn);
+            mesh_cull_stats.submitted = mesh_cull_stats.drawn = 0;
+#endif
+            frames = draws = draw_us = vertices = 0;
+        }
     }
 
+#if USE_MESH_FILES
+    for (int i = 0; i < sizeof(meshes) / sizeof(meshes[0]); i++)
+        mesh_destroy(&meshes[i]);
+#endif
     termGraphics();
 
     // Exit Game
@@ -6,9 +6,9 @@
 #include <pspgum.h>
 #include <pspdebug.h>
 #include <pspkernel.h>
+#include <pspiofilemgr.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include "gtex.h"
 
 #include <string.h>
 #include <malloc.h>
@@ -55,22 +55,27 @@ static unsigned int getMemorySize(unsigned int width, unsigned int height, unsig
     }
 }
 
-void *getStaticVramBuffer(unsigned int width, unsigned int height, unsigned int psm)
+// hands out VRAM from the start, nothing is ever given back. sizes are rounded to 16 bytes for the GE
+static void *getStaticVramBytes(unsigned int size)
 {
     static unsigned int staticOffset = 0;
 
-    unsigned int memSize = getMemorySize(width, height, psm);
-
     void *result = (void *)staticOffset;
 
-    staticOffset += memSize;
+    staticOffset += (size + 15) & ~15u;
 
     return result;
 }
 
-void *getStaticVramTexture(unsigned int width, unsigned int height, unsigned int psm)
+void *getStaticVramBuffer(unsigned int width, unsigned int height, unsigned int psm)
+{
+    return getStaticVramBytes(getMemorySize(width, height, psm));
+}
+
+// a texture of size bytes, cooked textures know their size with every level and padding
+void *getStaticVramTexture(unsigned int size)
 {
-    void *result = getStaticVramBuffer(width, height, psm);
+    void *result = getStaticVramBytes(size);
     return (void *)(((unsigned int)result) + ((unsigned int)sceGeEdramGetAddr()));
 }
 
@@ -163,14 +168,43 @@ void reset_translate(float x, float y, float z) // in 2d it resets the position
     sceGumTranslate(&v);
 }
 
-struct Vertex
+// the vertex format is declared once, the struct, its GU flags and a size check come from the same line.
+// X(struct name, flags name, texture, color, position, size in bytes)
+#define VC_TEXTURE_32BITF_MEMBERS float u, v;
+#define VC_TEXTURE_32BITF_FLAG GU_TEXTURE_32BITF
+#define VC_COLOR_8888_MEMBERS unsigned int color;
+#define VC_COLOR_8888_FLAG GU_COLOR_8888
+#define VC_VERTEX_32BITF_MEMBERS float x, y, z;
+#define VC_VERTEX_32BITF_FLAG GU_VERTEX_32BITF
+
+#define VERTEX_FORMAT_LIST(X) \
+    X(Vertex, VERTEX_FLAGS, TEXTURE_32BITF, COLOR_8888, VERTEX_32BITF, 24)
+
+#define VERTEX_STRUCT(name, flags, texture, color, position, size) \
+    struct name                                                     \
+    {                                                               \
+        VC_##texture##_MEMBERS                                      \
+        VC_##color##_MEMBERS                                        \
+        VC_##position##_MEMBERS                                     \
+    };                                                              \
+    _Static_assert(sizeof(struct name) == size, #name " is not " #size " bytes");
+VERTEX_FORMAT_LIST(VERTEX_STRUCT)
+#undef VERTEX_STRUCT
+
+#define VERTEX_ENUM(name, flags, texture, color, position, size) flags = VC_##texture##_FLAG | VC_##color##_FLAG | VC_##position##_FLAG,
+enum
 {
-    float u, v; // texture coordinates, not used in this example
-    unsigned int color;
-    float x, y, z;
+    VERTEX_FORMAT_LIST(VERTEX_ENUM)
 };
+#undef VERTEX_ENUM
 
-// we use aligned(16) to limit the vertex to onl take 16 bites since the bites or each vertex is 16 (hexcode = 4, floats = 4)
+// draws indexed triangles of struct Vertex through the gum matrices, the flags always match the struct
+static void draw_vertices(int count, const unsigned short *indices, const struct Vertex *vertices)
+{
+    sceGumDrawArray(GU_TRIANGLES, GU_INDEX_16BIT | VERTEX_FLAGS | GU_TRANSFORM_3D, count, indices, vertices);
+}
+
+// aligned(16) only aligns the start of the array for the GE, every vertex is 24 bytes (2 + 1 + 3 values of 4 bytes)
 struct Vertex __attribute__((aligned(16))) square_indexed[4] = {
     // this is like maillage from school. Probably gonna use this version the most
     {0.0f, 0.0f, 0xFF0000FF, -0.25f, -0.25f, -1.0f}, // 0
@@ -182,98 +216,108 @@ struct Vertex __attribute__((aligned(16))) square_indexed[4] = {
 unsigned short __attribute__((aligned(16))) square_indices[6] = { // table to tell the order of wich to link the vertices
     0, 1, 2, 2, 3, 0};
 
-unsigned int pow2(const unsigned int value) {
-    unsigned int poweroftwo = 1;
-    while (poweroftwo < value) {
-        poweroftwo <<= 1;
-    }
-    return poweroftwo;
-}
-
-void copy_texture_data(void* dest, const void* src, const int pW, const int width, const int height){
-    for (unsigned int y = 0; y < height; y++) {
-        for (unsigned int x = 0; x < width; x++) {
-            ((unsigned int*)dest)[x + y * pW] = ((unsigned int *)src)[x + y * width];
-        }
-    }
-}
-
-void swizzle_fast(u8 *out, const u8 *in, const unsigned int width, const unsigned int height) {
-    unsigned int blockx, blocky;
-    unsigned int j;
-
-    unsigned int width_blocks = (width / 16);
-    unsigned int height_blocks = (height / 8);
-
-    unsigned int src_pitch = (width - 16) / 4;
-    unsigned int src_row = width * 8;
-
-    const u8 *ysrc = in;
-    u32 *dst = (u32 *)out;
-
-    for (blocky = 0; blocky < height_blocks; ++blocky) {
-        const u8 *xsrc = ysrc;
-        for (blockx = 0; blockx < width_blocks; ++blockx) {
-            const u32 *src = (u32 *)xsrc;
-            for (j = 0; j < 8; ++j) {
-                *(dst++) = *(src++);
-                *(dst++) = *(src++);
-                *(dst++) = *(src++);
-                *(dst++) = *(src++);
-                src += src_pitch;
-            }
-            xsrc += 16;
-        }
-        ysrc += src_row;
-    }
-}
+// the cooker writes the GU_PSM_* values without pspgu.h
+_Static_assert(GTEX_PSM_5650 == GU_PSM_5650 && GTEX_PSM_5551 == GU_PSM_5551 && GTEX_PSM_4444 == GU_PSM_4444 &&
+                   GTEX_PSM_8888 == GU_PSM_8888 && GTEX_PSM_T4 == GU_PSM_T4 && GTEX_PSM_T8 == GU_PSM_T8,
+               "GtexPsm does not match GU_PSM_*");
 
 typedef struct {
     unsigned int width;
     unsigned int height;
     unsigned int pW, pH;
+    unsigned int psm;
+    unsigned int levels;
+    unsigned int swizzled;
+    unsigned int bufferWidth[GTEX_MAX_LEVELS];
+    void *level[GTEX_MAX_LEVELS]; // level[0] is the start of the texels
+    void *clut; // palette of T4 / T8 textures (8888 colors), NULL for direct color
+    unsigned int clutColors;
     void *data; // pointer to the data
 }Texture;
 
+// is a block of size bytes at offset (from the start of the file) inside the texels, and 16 byte aligned
+// like the GE wants it once the texels are loaded to a 16 byte aligned address
+static int valid_range(const struct GtexHeader *header, unsigned int offset, unsigned int size) {
+    return offset >= header->header_size && (offset - header->header_size) % 16 == 0 &&
+           offset - header->header_size <= header->data_size && size <= header->data_size - (offset - header->header_size);
+}
+
+// a truncated or edited file must not make the GE sample outside the block that was read
+static int valid_header(const struct GtexHeader *header) {
+    if(memcmp(header->magic, GTEX_MAGIC, 4) != 0 || header->version != GTEX_VERSION ||
+       header->header_size < sizeof(*header) || header->levels < 1 || header->levels > GTEX_MAX_LEVELS ||
+       header->psm > GTEX_PSM_T8 || header->data_size == 0 || header->pow2_width == 0 || header->pow2_width > 512 ||
+       header->pow2_height == 0 || header->pow2_height > 512)
+        return 0;
+
+    for (unsigned int i = 0; i < header->levels; i++) {
+        unsigned int w = header->pow2_width >> i, h = header->pow2_height >> i;
+        w = w ? w : 1;
+        h = h ? h : 1;
+        unsigned int size = header->buffer_width[i] * gtex_buffer_height(h, header->swizzled) * gtex_bits_per_pixel(header->psm) / 8;
+        if(header->buffer_width[i] < gtex_buffer_width(header->psm, w) || !valid_range(header, header->level_offset[i], size))
+            return 0;
+    }
+
+    if(gtex_indexed(header->psm))
+        return header->clut_colors == (header->psm == GTEX_PSM_T4 ? 16u : 256u) &&
+               valid_range(header, header->clut_offset, header->clut_colors * 4);
+    return 1;
+}
+
+// reads a .gtex file made by tools/texture_cook.c. the texels are already what the GE samples, so they
+// are read in one go where they stay, in VRAM or in RAM
 Texture* load_texture(const char* filename, const int vram) {
-    int width, height, nrChannels;    
-    stbi_set_flip_vertically_on_load(GU_TRUE);
-    unsigned char *data = stbi_load(filename, &width, &height,
-                                    &nrChannels, STBI_rgb_alpha);
+    unsigned int start = sceKernelGetSystemTimeLow();
 
-    if(!data)
+    SceUID file = sceIoOpen(filename, PSP_O_RDONLY, 0777);
+    if(file < 0)
         return NULL;
 
-    Texture* tex = (Texture*)malloc(sizeof(Texture));
-    tex->width = width;
-    tex->height = height;
-    tex->pW = pow2(width);
-    tex->pH = pow2(height);
-
-    unsigned int *dataBuffer =
-        (unsigned int *)memalign(16, tex->pH * tex->pW * 4);
-
-    // Copy to Data Buffer
-    copy_texture_data(dataBuffer, data, tex->pW, tex->width, tex->height);
-
-    // Free STB Data
-    stbi_image_free(data);
-
-    unsigned int* swizzled_pixels = NULL;
-    size_t size = tex->pH * tex->pW * 4;
-    if(vram){
-        swizzled_pixels = getStaticVramTexture(tex->pW, tex->pH, GU_PSM_8888);
-    } else {
-        swizzled_pixels = (unsigned int *)memalign(16, size);
+    struct GtexHeader header;
+    if(sceIoRead(file, &header, sizeof(header)) != sizeof(header) || !valid_header(&header)) {
+        sceIoClose(file);
+        return NULL;
     }
-    
-    swizzle_fast((u8*)swizzled_pixels, (const u8*)dataBuffer, tex->pW * 4, tex->pH);
+    if(header.header_size != sizeof(header))
+        sceIoLseek32(file, header.header_size, PSP_SEEK_SET);
 
-    free(dataBuffer);
-    tex->data = swizzled_pixels;
+    void *data = vram ? getStaticVramTexture(header.data_size) : memalign(16, header.data_size);
+    if(data == NULL) {
+        sceIoClose(file);
+        return NULL;
+    }
 
-    sceKernelDcacheWritebackInvalidateAll();
+    // nothing of the destination may be left in the cache to be written back over the texels later
+    sceKernelDcacheWritebackInvalidateRange(data, header.data_size);
+    int read = sceIoRead(file, data, header.data_size);
+    sceIoClose(file);
+    if(read != (int)header.data_size) {
+        if(!vram)
+            free(data);
+        return NULL;
+    }
+    // the read may have gone through the cache, the GE reads memory
+    sceKernelDcacheWritebackInvalidateRange(data, header.data_size);
 
+    Texture* tex = (Texture*)malloc(sizeof(Texture));
+    tex->width = header.width;
+    tex->height = header.height;
+    tex->pW = header.pow2_width;
+    tex->pH = header.pow2_height;
+    tex->psm = header.psm;
+    tex->levels = header.levels;
+    tex->swizzled = header.swizzled;
+    for (unsigned int i = 0; i < header.levels; i++) {
+        tex->bufferWidth[i] = header.buffer_width[i];
+        tex->level[i] = (unsigned char *)data + header.level_offset[i] - header.header_size;
+    }
+    tex->clut = gtex_indexed(header.psm) ? (unsigned char *)data + header.clut_offset - header.header_size : NULL;
+    tex->clutColors = gtex_indexed(header.psm) ? header.clut_colors : 0;
+    tex->data = data;
+
+    printf("%s: %ux%u, %u level(s), %u bytes in %u us\n", filename, tex->pW, tex->pH, tex->levels,
+           header.data_size, sceKernelGetSystemTimeLow() - start);
     return tex;
 }
 
@@ -281,11 +325,25 @@ void bind_texture(Texture* tex) {
     if(tex == NULL)
         return;
 
-    sceGuTexMode(GU_PSM_8888, 0, 0, 1);
+    // the GE keeps a loaded palette from list to list, it is only loaded again for another one
+    static const void *boundClut = NULL;
+    if(tex->clut != NULL && tex->clut != boundClut) {
+        sceGuClutMode(GU_PSM_8888, 0, 0xff, 0);
+        sceGuClutLoad(tex->clutColors / 8, tex->clut); // in blocks of 8 colors of 32 bits
+        boundClut = tex->clut;
+    }
+
+    sceGuTexMode(tex->psm, tex->levels - 1, 0, tex->swizzled);
     sceGuTexFunc(GU_TFX_MODULATE, GU_TCC_RGBA);
-    sceGuTexFilter(GU_NEAREST, GU_NEAREST);
+    if(tex->levels > 1)
+        sceGuTexFilter(GU_NEAREST_MIPMAP_NEAREST, GU_NEAREST);
+    else
+        sceGuTexFilter(GU_NEAREST, GU_NEAREST);
     sceGuTexWrap(GU_REPEAT, GU_REPEAT);
-    sceGuTexImage(0, tex->pW, tex->pH, tex->pW, tex->data);
+    for (unsigned int i = 0; i < tex->levels; i++) {
+        unsigned int w = tex->pW >> i, h = tex->pH >> i;
+        sceGuTexImage(i, w ? w : 1, h ? h : 1, tex->bufferWidth[i], tex->level[i]);
+    }
 }
 
 int main()
@@ -308,11 +366,16 @@ int main()
     sceGumMatrixMode(GU_MODEL); // positions of current model
     sceGumLoadIdentity();
 
-    Texture* texture = load_texture("container.jpg", GU_TRUE); // load the texture from the file
+    Texture* texture = load_texture("container.gtex", GU_TRUE); // load the texture from the file
     if(!texture){
         goto cleanup; // if the texture failed to load, exit
     }
 
+    Texture* circle = load_texture("circle.gtex", GU_TRUE); // T8, a quarter of the memory of 8888
+    if(!circle){
+        goto cleanup;
+    }
+
     // Main program loop
     while (running)
     {
@@ -327,7 +390,14 @@ int main()
 
         reset_translate(0.5f, 0.25f, 0.0f);
         bind_texture(texture); // bind the texture to the graphics engine
-        sceGumDrawArray(GU_TRIANGLES, GU_INDEX_16BIT | GU_TEXTURE_32BITF | GU_COLOR_8888 | GU_VERTEX_32BITF | GU_TRANSFORM_3D, 6, square_indices, square_indexed);
+        draw_vertices(6, square_indices, square_indexed);
+
+        sceGuEnable(GU_BLEND);
+        sceGuBlendFunc(GU_ADD, GU_SRC_ALPHA, GU_ONE_MINUS_SRC_ALPHA, 0, 0);
+        reset_translate(-0.5f, 0.25f, 0.0f);
+        bind_texture(circle);
+        draw_vertices(6, square_indices, square_indexed);
+        sceGuDisable(GU_BLEND);
 
         endFrame();
     }
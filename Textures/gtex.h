@@ -0,0 +1,76 @@
+#ifndef GTEX_INCLUDE
+#define GTEX_INCLUDE
+
+// .gtex textures, cooked on the host by tools/texture_cook.c: already flipped, padded to powers of two,
+// converted to the pixel format the GE samples (or quantized to a palette), mipmapped and swizzled. the
+// loader reads the header, then every level and the palette in one read straight where the GE samples them
+#define GTEX_MAGIC "GTEX"
+#define GTEX_VERSION (2)
+#define GTEX_MAX_LEVELS (8)
+
+// the pixel formats, the values of GU_PSM_* (the cooker has no pspgu.h)
+enum GtexPsm
+{
+    GTEX_PSM_5650 = 0,
+    GTEX_PSM_5551 = 1,
+    GTEX_PSM_4444 = 2,
+    GTEX_PSM_8888 = 3,
+    GTEX_PSM_T4 = 4, // 4 bit indices into a palette of 16 colors
+    GTEX_PSM_T8 = 5, // 8 bit indices into a palette of 256 colors
+};
+
+// all the fields are little endian like the PSP. the levels follow each other from level_offset[0],
+// each 16 byte aligned, then the palette of indexed textures, so they read as one block of data_size bytes.
+// palettes are 8888 colors, what sceGuClutLoad reads
+struct GtexHeader
+{
+    char magic[4];                               // GTEX_MAGIC
+    unsigned short version;                      // GTEX_VERSION
+    unsigned short header_size;                  // offset of the first level, lets newer headers grow
+    unsigned short width, height;                // of the image, what the texture coordinates were made for
+    unsigned short pow2_width, pow2_height;      // of level 0, every next level is half as big (at least 1)
+    unsigned char psm;                           // enum GtexPsm
+    unsigned char levels;                        // 1 .. GTEX_MAX_LEVELS, level 0 included
+    unsigned char swizzled;                      // sceGuTexMode swizzle flag
+    unsigned char reserved;
+    unsigned int data_size;                      // every level with its padding
+    unsigned int level_offset[GTEX_MAX_LEVELS];  // from the start of the file
+    unsigned short buffer_width[GTEX_MAX_LEVELS]; // in pixels, what sceGuTexImage takes as tbw
+    unsigned int clut_offset;                    // from the start of the file, 0 for direct color
+    unsigned int clut_colors;                    // 16 for T4, 256 for T8, 0 for direct color
+};
+
+static inline unsigned int gtex_bits_per_pixel(unsigned int psm)
+{
+    switch (psm)
+    {
+    case GTEX_PSM_T4:
+        return 4;
+    case GTEX_PSM_T8:
+        return 8;
+    case GTEX_PSM_8888:
+        return 32;
+    }
+    return 16;
+}
+
+static inline int gtex_indexed(unsigned int psm)
+{
+    return psm == GTEX_PSM_T4 || psm == GTEX_PSM_T8;
+}
+
+// rows are at least 16 bytes and a multiple of 8 pixels: the width of a swizzle block (32 T4 or 16 T8
+// texels), and what the GE wants as a buffer width
+static inline unsigned int gtex_buffer_width(unsigned int psm, unsigned int width)
+{
+    unsigned int minimum = 128 / gtex_bits_per_pixel(psm);
+    minimum = minimum < 8 ? 8 : minimum;
+    return width < minimum ? minimum : (width + 7) & ~7u;
+}
+
+// swizzled levels are stored in blocks of 8 rows, smaller levels are padded to that
+static inline unsigned int gtex_buffer_height(unsigned int height, int swizzled)
+{
+    return swizzled ? (height + 7) & ~7u : height;
+}
+#endif
@@ -0,0 +1,407 @@
+// Host texture cooker, turns an image into the .gtex file the texture loader of Textures.c reads
+//
+// build from Textures/ with your host compiler:
+//     gcc -O2 -o texture_cook tools/texture_cook.c -lm
+//     ./texture_cook container.jpg container.gtex [--psm 8888|4444|5551|5650|t4|t8] [--mips n] [--linear]
+//
+// everything load_texture used to do on the PSP at startup is done here: decoding (any format
+// stb_image reads), the vertical flip, the padding to powers of two, the conversion to the pixel
+// format, and the swizzle (--linear keeps the rows as they are). --mips n adds mipmaps, each level
+// a 2x2 box filter of the one before, up to n levels in all (default 1, no mipmaps)
+//
+// t4 and t8 quantize the image to a palette of 16 or 256 colors, alpha included: the exact colors when
+// there are few enough, else a median cut (the box with the widest channel is split at its median until
+// there are enough boxes, each color the average of its box). every texel, of the mipmaps too, is the
+// index of the closest palette color
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../stb_image.h"
+
+#include "../gtex.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned int pow2(unsigned int value)
+{
+    unsigned int power = 1;
+    while (power < value)
+        power <<= 1;
+    return power;
+}
+
+static unsigned int align16(unsigned int offset)
+{
+    return (offset + 15) & ~15u;
+}
+
+static unsigned int rgba_key(const unsigned char *rgba)
+{
+    return rgba[0] | rgba[1] << 8 | rgba[2] << 16 | (unsigned int)rgba[3] << 24;
+}
+
+static int compare_key(const void *a, const void *b)
+{
+    unsigned int x = rgba_key(a), y = rgba_key(b);
+    return x < y ? -1 : x > y;
+}
+
+static int sort_channel;
+
+static int compare_channel(const void *a, const void *b)
+{
+    return ((const unsigned char *)a)[sort_channel] - ((const unsigned char *)b)[sort_channel];
+}
+
+struct Box
+{
+    unsigned int start, count; // pixels of the box in the sorted copy
+    int channel;               // its widest channel
+    int range;                 // the width of it
+};
+
+static void measure(struct Box *box, const unsigned char *pixels)
+{
+    box->range = -1;
+    for (int c = 0; c < 4; c++)
+    {
+        int low = 255, high = 0;
+        for (unsigned int i = box->start; i < box->start + box->count; i++)
+        {
+            int value = pixels[i * 4 + c];
+            low = value < low ? value : low;
+            high = value > high ? value : high;
+        }
+        if (high - low > box->range)
+        {
+            box->range = high - low;
+            box->channel = c;
+        }
+    }
+}
+
+// fills palette (RGBA) with at most colors colors for the count pixels, returns how many it made
+static unsigned int quantize(unsigned char *palette, unsigned int colors, const unsigned char *image, unsigned int count)
+{
+    unsigned char *pixels = (unsigned char *)malloc(count * 4);
+    memcpy(pixels, image, count * 4);
+
+    // few enough colors: those exactly
+    qsort(pixels, count, 4, compare_key);
+    unsigned int unique = 0;
+    for (unsigned int i = 0; i < count && unique <= colors; i++)
+    {
+        if (i == 0 || rgba_key(pixels + i * 4) != rgba_key(pixels + (i - 1) * 4))
+        {
+            if (unique < colors)
+                memcpy(palette + unique * 4, pixels + i * 4, 4);
+            unique++;
+        }
+    }
+    if (unique <= colors)
+    {
+        free(pixels);
+        return unique;
+    }
+
+    struct Box boxes[256];
+    unsigned int box_count = 1;
+    boxes[0].start = 0;
+    boxes[0].count = count;
+    measure(&boxes[0], pixels);
+
+    while (box_count < colors)
+    {
+        struct Box *widest = NULL;
+        for (unsigned int i = 0; i < box_count; i++)
+            if (boxes[i].range > 0 && (widest == NULL || boxes[i].range > widest->range))
+                widest = &boxes[i];
+        if (widest == NULL)
+            break;
+
+        sort_channel = widest->channel;
+        qsort(pixels + widest->start * 4, widest->count, 4, compare_channel);
+
+        struct Box *half = &boxes[box_count++];
+        half->start = widest->start + widest->count / 2;
+        half->count = widest->count - widest->count / 2;
+        widest->count /= 2;
+        measure(widest, pixels);
+        measure(half, pixels);
+    }
+
+    for (unsigned int i = 0; i < box_count; i++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            unsigned long long sum = 0;
+            for (unsigned int j = boxes[i].start; j < boxes[i].start + boxes[i].count; j++)
+                sum += pixels[j * 4 + c];
+            palette[i * 4 + c] = (sum + boxes[i].count / 2) / boxes[i].count;
+        }
+    }
+    free(pixels);
+    return box_count;
+}
+
+static unsigned int closest(const unsigned char *palette, unsigned int colors, const unsigned char *rgba, unsigned int *distance)
+{
+    unsigned int best = 0, best_distance = ~0u;
+    for (unsigned int i = 0; i < colors && best_distance > 0; i++)
+    {
+        unsigned int d = 0;
+        for (int c = 0; c < 4; c++)
+            d += (palette[i * 4 + c] - rgba[c]) * (palette[i * 4 + c] - rgba[c]);
+        if (d < best_distance)
+        {
+            best_distance = d;
+            best = i;
+        }
+    }
+    *distance = best_distance;
+    return best;
+}
+
+// one texel of bits bits at x of a row, T4 puts the first texel in the low nibble
+static void put_texel(unsigned char *row, unsigned int x, unsigned int bits, unsigned int texel)
+{
+    if (bits == 4)
+        row[x / 2] |= texel << (x & 1) * 4;
+    else
+        memcpy(row + x * bits / 8, &texel, bits / 8);
+}
+
+// 0 .. 255 to bits bits, rounded
+static unsigned int to_bits(unsigned char value, int bits)
+{
+    return (value * ((1u << bits) - 1) + 127) / 255;
+}
+
+// one RGBA pixel in a direct color GE format, red in the low bits
+static unsigned int convert_pixel(const unsigned char *rgba, unsigned int psm)
+{
+    switch (psm)
+    {
+    case GTEX_PSM_5650:
+        return to_bits(rgba[0], 5) | to_bits(rgba[1], 6) << 5 | to_bits(rgba[2], 5) << 11;
+    case GTEX_PSM_5551:
+        return to_bits(rgba[0], 5) | to_bits(rgba[1], 5) << 5 | to_bits(rgba[2], 5) << 10 | to_bits(rgba[3], 1) << 15;
+    case GTEX_PSM_4444:
+        return to_bits(rgba[0], 4) | to_bits(rgba[1], 4) << 4 | to_bits(rgba[2], 4) << 8 | to_bits(rgba[3], 4) << 12;
+    }
+    return rgba[0] | rgba[1] << 8 | rgba[2] << 16 | (unsigned int)rgba[3] << 24;
+}
+
+// half the size in each direction (not below 1), every pixel the average of the 2x2 it covers
+static void downsample(unsigned char *out, const unsigned char *in, unsigned int width, unsigned int height)
+{
+    unsigned int out_width = width > 1 ? width / 2 : 1, out_height = height > 1 ? height / 2 : 1;
+    for (unsigned int y = 0; y < out_height; y++)
+    {
+        for (unsigned int x = 0; x < out_width; x++)
+        {
+            unsigned int x0 = x * 2, x1 = width > 1 ? x * 2 + 1 : x * 2;
+            unsigned int y0 = y * 2, y1 = height > 1 ? y * 2 + 1 : y * 2;
+            for (int c = 0; c < 4; c++)
+            {
+                unsigned int sum = in[(y0 * width + x0) * 4 + c] + in[(y0 * width + x1) * 4 + c] + in[(y1 * width + x0) * 4 + c] +
+                                   in[(y1 * width + x1) * 4 + c];
+                out[(y * out_width + x) * 4 + c] = (sum + 2) / 4;
+            }
+        }
+    }
+}
+
+// the same as swizzle_fast did on the PSP: 16 byte x 8 row blocks, left to right then top to bottom
+static void swizzle(unsigned char *out, const unsigned char *in, unsigned int row_bytes, unsigned int rows)
+{
+    for (unsigned int block_y = 0; block_y < rows / 8; block_y++)
+        for (unsigned int block_x = 0; block_x < row_bytes / 16; block_x++)
+            for (unsigned int j = 0; j < 8; j++, out += 16)
+                memcpy(out, in + (block_y * 8 + j) * row_bytes + block_x * 16, 16);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <image> <texture.gtex> [--psm 8888|4444|5551|5650|t4|t8] [--mips n] [--linear]\n", argv[0]);
+        return 1;
+    }
+
+    unsigned int psm = GTEX_PSM_8888, levels = 1;
+    int swizzled = 1;
+    for (int i = 3; i < argc; i++)
+    {
+        static const char *names[] = {"5650", "5551", "4444", "8888", "t4", "t8"};
+        int ok = 1;
+        if (strcmp(argv[i], "--linear") == 0)
+        {
+            swizzled = 0;
+        }
+        else if (strcmp(argv[i], "--mips") == 0 && i + 1 < argc)
+        {
+            levels = atoi(argv[++i]);
+            ok = levels >= 1 && levels <= GTEX_MAX_LEVELS;
+        }
+        else if (strcmp(argv[i], "--psm") == 0 && i + 1 < argc)
+        {
+            i++;
+            for (psm = 0; psm <= GTEX_PSM_T8 && strcmp(argv[i], names[psm]) != 0; psm++)
+                ;
+            ok = psm <= GTEX_PSM_T8;
+        }
+        else
+        {
+            ok = 0;
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "bad option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    // flipped like load_texture did, the bottom row first
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load(1);
+    unsigned char *image = stbi_load(argv[1], &width, &height, &channels, STBI_rgb_alpha);
+    if (image == NULL)
+    {
+        fprintf(stderr, "cannot read %s: %s\n", argv[1], stbi_failure_reason());
+        return 1;
+    }
+    if (width > 512 || height > 512)
+    {
+        fprintf(stderr, "%s: %dx%d, the GE samples at most 512x512\n", argv[1], width, height);
+        return 1;
+    }
+
+    // the palette comes from the image only, not from its padding
+    unsigned char palette[256 * 4];
+    unsigned int colors = 0;
+    if (gtex_indexed(psm))
+        colors = quantize(palette, psm == GTEX_PSM_T4 ? 16 : 256, image, width * height);
+
+    // level 0 padded to powers of two with transparent black
+    unsigned int pow2_width = pow2(width), pow2_height = pow2(height);
+    unsigned char *level = (unsigned char *)calloc(pow2_width * pow2_height, 4);
+    for (int y = 0; y < height; y++)
+        memcpy(level + y * pow2_width * 4, image + y * width * 4, width * 4);
+    stbi_image_free(image);
+
+    // the smallest level is 1x1
+    unsigned int largest = pow2_width > pow2_height ? pow2_width : pow2_height;
+    unsigned int possible = 1;
+    while ((largest >> (possible - 1)) > 1)
+        possible++;
+    levels = levels < possible ? levels : possible;
+
+    struct GtexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GTEX_MAGIC, 4);
+    header.version = GTEX_VERSION;
+    header.header_size = align16(sizeof(header));
+    header.width = width;
+    header.height = height;
+    header.pow2_width = pow2_width;
+    header.pow2_height = pow2_height;
+    header.psm = psm;
+    header.levels = levels;
+    header.swizzled = swizzled;
+
+    // the size of every level first, they all go in one block
+    unsigned int offset = header.header_size;
+    for (unsigned int i = 0; i < levels; i++)
+    {
+        unsigned int w = pow2_width >> i ? pow2_width >> i : 1, h = pow2_height >> i ? pow2_height >> i : 1;
+        header.level_offset[i] = offset;
+        header.buffer_width[i] = gtex_buffer_width(psm, w);
+        offset = align16(offset + header.buffer_width[i] * gtex_buffer_height(h, swizzled) * gtex_bits_per_pixel(psm) / 8);
+    }
+    if (gtex_indexed(psm))
+    {
+        header.clut_offset = offset;
+        header.clut_colors = psm == GTEX_PSM_T4 ? 16 : 256;
+        offset += header.clut_colors * 4;
+    }
+    header.data_size = offset - header.header_size;
+
+    unsigned char *file = (unsigned char *)calloc(offset, 1);
+    memcpy(file, &header, sizeof(header));
+
+    // unused palette entries stay transparent black
+    for (unsigned int i = 0; i < colors; i++)
+    {
+        unsigned int color = convert_pixel(palette + i * 4, GTEX_PSM_8888);
+        memcpy(file + header.clut_offset + i * 4, &color, 4);
+    }
+
+    unsigned int bits = gtex_bits_per_pixel(psm);
+    double error = 0.0;
+    for (unsigned int i = 0; i < levels; i++)
+    {
+        unsigned int w = pow2_width >> i ? pow2_width >> i : 1, h = pow2_height >> i ? pow2_height >> i : 1;
+        unsigned int row_bytes = header.buffer_width[i] * bits / 8, rows = gtex_buffer_height(h, swizzled);
+
+        // converted rows at the buffer width, then swizzled in place of the linear ones
+        unsigned char *linear = (unsigned char *)calloc(row_bytes * rows, 1);
+        for (unsigned int y = 0; y < h; y++)
+        {
+            for (unsigned int x = 0; x < w; x++)
+            {
+                const unsigned char *rgba = level + (y * w + x) * 4;
+                unsigned int texel, distance;
+                if (gtex_indexed(psm))
+                {
+                    texel = closest(palette, colors, rgba, &distance);
+                    if (i == 0 && x < (unsigned int)width && y < (unsigned int)height)
+                        error += distance;
+                }
+                else
+                {
+                    texel = convert_pixel(rgba, psm);
+                }
+                put_texel(linear + y * row_bytes, x, bits, texel);
+            }
+        }
+
+        if (swizzled)
+            swizzle(file + header.level_offset[i], linear, row_bytes, rows);
+        else
+            memcpy(file + header.level_offset[i], linear, row_bytes * rows);
+        free(linear);
+
+        if (i + 1 < levels)
+        {
+            unsigned char *next = (unsigned char *)malloc((w > 1 ? w / 2 : 1) * (h > 1 ? h / 2 : 1) * 4);
+            downsample(next, level, w, h);
+            free(level);
+            level = next;
+        }
+    }
+    free(level);
+
+    FILE *out = fopen(argv[2], "wb");
+    if (out == NULL)
+    {
+        fprintf(stderr, "cannot create %s\n", argv[2]);
+        return 1;
+    }
+    int ok = fwrite(file, offset, 1, out) == 1;
+    ok = fclose(out) == 0 && ok;
+    if (!ok)
+    {
+        fprintf(stderr, "failed to write %s\n", argv[2]);
+        return 1;
+    }
+
+    printf("%s: %dx%d as %ux%u, %u level%s, %u bytes of texels%s\n", argv[2], width, height, pow2_width, pow2_height, levels,
+           levels > 1 ? "s" : "", header.data_size, swizzled ? ", swizzled" : "");
+    if (gtex_indexed(psm))
+        printf("palette of %u/%u colors, rms error %.2f per channel\n", colors, header.clut_colors,
+               sqrt(error / ((double)width * height * 4)));
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "headers/atlas.h"
+#include "headers/tiles.h"
+
+#include <pspgu.h>
+#include <pspkernel.h>
+#include <malloc.h>
+#include <stdlib.h>
+
+static unsigned int *atlas_pixels = NULL;
+
+static unsigned int darken(unsigned int color)
+{
+    return (color & 0xFF000000) | ((color >> 1) & 0x007F7F7F);
+}
+
+// color of texel x, y (y = 0 is the top row) of an animation frame or an autotile variant of a tile.
+// variants have bit 0 set at the start of a run (left or bottom) and bit 1 at its end (right or top)
+static unsigned int tile_texel(unsigned int tile, unsigned int color, int x, int y, int frame)
+{
+    switch (tile)
+    {
+    case TILE_BRICK:
+        // the ends of a run of bricks get a mortar edge
+        if (((frame & 1) && x == 0) || ((frame & 2) && x == ATLAS_CELL - 1))
+            return darken(color);
+        // mortar lines, every other row of bricks is shifted by half a brick
+        if (y % 8 == 7 || x == (y < 8 ? 7 : 15))
+            return darken(color);
+        return color;
+
+    case TILE_LADDER:
+        // the rails stop short at the bottom of a ladder and end in a rung at its top
+        if (((frame & 1) && y >= ATLAS_CELL - 2) || ((frame & 2) && y < 1))
+            return 0xFF000000;
+        if ((frame & 2) && y == 1 && x >= 2 && x <= 13)
+            return color;
+        if (x == 2 || x == 3 || x == 12 || x == 13 || (y % 4 == 1 && x > 3 && x < 12))
+            return color;
+        return 0xFF000000;
+
+    case TILE_GOLD:
+        if ((y >= 8 && y <= 13 && x >= 4 && x <= 11) || (y >= 6 && y < 8 && x >= 6 && x <= 9))
+        {
+            // the glint runs diagonally across the nugget, the last frame has none
+            if (frame < 3 && x + y == 12 + frame * 3)
+                return 0xFFFFFFFF;
+            return color;
+        }
+        return 0xFF000000;
+
+    case TILE_CONCRETE:
+    case TILE_BACKDROP:
+        if (x == 0 || y == 0 || x == ATLAS_CELL - 1 || y == ATLAS_CELL - 1)
+            return darken(color);
+        return color;
+
+    default:
+        return color;
+    }
+}
+
+int atlas_create(void)
+{
+    atlas_pixels = (unsigned int *)memalign(16, ATLAS_WIDTH * ATLAS_HEIGHT * sizeof(unsigned int));
+    if (!atlas_pixels)
+        return -1;
+
+    for (unsigned int i = 0; i < ATLAS_WIDTH * ATLAS_HEIGHT; i++)
+        atlas_pixels[i] = 0xFF000000;
+
+    for (unsigned int tile = 0; tile < TILE_TABLE_SIZE; tile++)
+    {
+        const struct TileProperties *p = &tile_properties[tile];
+        if (p->layer == LAYER_NONE)
+            continue;
+
+        unsigned int rows = p->autotile != AUTOTILE_NONE ? AUTOTILE_VARIANTS : p->frames;
+        for (int frame = 0; frame < rows; frame++)
+        {
+            unsigned int *cell = atlas_pixels + (p->v + frame) * ATLAS_CELL * ATLAS_WIDTH + p->u * ATLAS_CELL;
+
+            for (int y = 0; y < ATLAS_CELL; y++)
+                for (int x = 0; x < ATLAS_CELL; x++)
+                    cell[y * ATLAS_WIDTH + x] = tile_texel(tile, p->color, x, y, frame);
+        }
+    }
+
+    // the GE reads the texture straight from RAM
+    sceKernelDcacheWritebackRange(atlas_pixels, ATLAS_WIDTH * ATLAS_HEIGHT * sizeof(unsigned int));
+    return 0;
+}
+
+void atlas_destroy(void)
+{
+    free(atlas_pixels);
+    atlas_pixels = NULL;
+}
+
+void atlas_bind(void)
+{
+    sceGuEnable(GU_TEXTURE_2D);
+    sceGuTexMode(GU_PSM_8888, 0, 0, 0);
+    sceGuTexFunc(GU_TFX_REPLACE, GU_TCC_RGB);
+    sceGuTexFilter(GU_NEAREST, GU_NEAREST);
+    sceGuTexWrap(GU_REPEAT, GU_REPEAT);
+    sceGuTexImage(0, ATLAS_WIDTH, ATLAS_HEIGHT, ATLAS_WIDTH, atlas_pixels);
+
+    // animations move the texture coordinates with the offset, every draw starts from frame 0
+    sceGuTexMapMode(GU_TEXTURE_COORDS, 0, 0);
+    sceGuTexScale(1.0f, 1.0f);
+    sceGuTexOffset(0.0f, 0.0f);
+}
@@ -1,25 +1,35 @@
 // Include personal functions
-#include "headers/table.h"
+#include "headers/tilemap.h"
+#include "headers/levelstream.h"
+#include "headers/layers.h"
+#include "headers/atlas.h"
+#include "headers/scrollring.h"
+#include "headers/screen.h"
+#include "headers/matrix.h"
+#include "headers/gpubuffer.h"
 
 // Include Graphics Libraries
 #include <pspdisplay.h>
 #include <pspgu.h>
-#include <pspgum.h>
 #include <pspdebug.h>
+#include <pspctrl.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <pspkernel.h>
 
 // PSP Module Info
 PSP_MODULE_INFO("context", 0, 1, 1);
 PSP_MAIN_THREAD_ATTR(THREAD_ATTR_USER | THREAD_ATTR_VFPU);
 
-// Define PSP Width / Heightp
-#define PSP_BUF_WIDTH (512)
-#define PSP_SCR_WIDTH (480)  // screen width
-#define PSP_SCR_HEIGHT (272) // screen height
-
 // Global variables
 int running = 1;
+void *draw_buffer;   // frame buffer the current frame is drawn into, VRAM relative
+void *ring_vram;     // scroll ring texture, see scrollring.h
+void *geometry_vram; // static vertices and indices, see gpubuffer.h
+
+// what is left of the 2 MB of EDRAM after the frame buffers, the depth buffer and the scroll ring
+#define GEOMETRY_VRAM_SIZE (160 * 1024)
+
 // GE LIST
 static unsigned int __attribute__((aligned(16))) list[262144];
 
@@ -74,6 +84,9 @@ void initGraphics()
     void *fbp0 = getStaticVramBuffer(PSP_BUF_WIDTH, PSP_SCR_HEIGHT, GU_PSM_8888);
     void *fbp1 = getStaticVramBuffer(PSP_BUF_WIDTH, PSP_SCR_HEIGHT, GU_PSM_8888);
     void *zbp = getStaticVramBuffer(PSP_BUF_WIDTH, PSP_SCR_HEIGHT, GU_PSM_4444);
+    ring_vram = getStaticVramBuffer(RING_SIZE, RING_SIZE, RING_PSM);
+    geometry_vram = getStaticVramBuffer(GEOMETRY_VRAM_SIZE / 4, 1, GU_PSM_8888);
+    draw_buffer = fbp0;
 
     sceGuInit();
 
@@ -146,7 +159,7 @@ void endFrame()
     sceGuFinish();
     sceGuSync(0, 0);
     sceDisplayWaitVblankStart();
-    sceGuSwapBuffers(); // swaps displayBuffer with drawBuffer
+    draw_buffer = sceGuSwapBuffers(); // swaps displayBuffer with drawBuffer
 }
 
 void reset_translate(float x, float y, float z) // in 2d it resets the position of zero in the mapto the specified point like (objc2d.trancslate in webgl)
@@ -154,115 +167,71 @@ void reset_translate(float x, float y, float z) // in 2d it resets the position
     /* y points increase going up
 
     */
-    sceGumMatrixMode(GU_MODEL);
-    sceGumLoadIdentity();
-
-    ScePspFVector3 v = {x, y, z};
-    sceGumTranslate(&v);
+    matrix_mode(GU_MODEL);
+    matrix_identity();
+    matrix_translate(x, y, z);
 }
 
-struct Vertex
-{
-    unsigned int color;
-    float x, y, z;
-};
-
-// we use aligned(16) to limit the vertex to onl take 16 bites since the bites or each vertex is 16 (hexcode = 4, floats = 4)
-struct Vertex __attribute__((aligned(16))) square_indexed[4] = {
-    // this is like maillage from school. Probably gonna use this version the most
-    {0xFF0000FF, 0.0f, 0.0f, -1.0f},                           // 0
-    {0xFF0000FF, 0.0f, 1.0f / 27.0f, -1.0f},                   // 1
-    {0xFF00FF00, (16.0f / 9.0f) / 17.0f, 1.0f / 27.0f, -1.0f}, // 2
-    {0xFFFF0000, (16.0f / 9.0f) / 17.0f, 0.0f, -1.0f},         // 3
-
-    /*
-    {0xFF0000FF, 0.0f, 0.0f, -1.0f}, // 0
-    {0xFF0000FF, 0.0f, 0.50f, -1.0f},  // 1
-    {0xFF00FF00, 0.50f, 0.50f, -1.0f},   // 2
-    {0xFFFF0000, 0.50f, 0.0f, -1.0f},  // 3
-    */
-};
-
-unsigned short __attribute__((aligned(16))) square_indices[6] = { // table to tell the order of wich to link the vertices
-    0, 1, 2, 2, 3, 0};
-
-// struct Vertex *vertex_lists[2] = {triangle, square_indexed};
-// short *indices_list[2] = {triangle_indices, square_indices};
-// int vertex_count[2] = {3, 6};
-
-#define NUM_SQUARES (17 * 28)
-struct Vertex all_squares[NUM_SQUARES][4];
-int square_count = 0;
-// unsigned int (*tab)[28] = NULL;
-
-// table
-static unsigned int table[17][28] = {{6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6},
-                                     {2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2},
-                                     {1, 1, 1, 1, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 5, 1, 1, 1, 1, 1, 1, 1, 1, 3},
-                                     {1, 1, 1, 1, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 3},
-                                     {1, 1, 1, 1, 1, 1, 1, 5, 1, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 3, 1, 1, 1, 5, 1, 1, 1},
-                                     {1, 1, 1, 1, 1, 1, 1, 1, 1, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 3, 1, 1, 1, 1, 1, 1, 1},
-                                     {2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 1, 1, 1, 1, 1, 1, 1},
-                                     {1, 1, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 3, 1, 1, 1, 1, 1, 1, 1},
-                                     {1, 1, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 3, 1, 1, 1, 1, 1, 1, 1},
-                                     {2, 2, 3, 2, 2, 2, 2, 2, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 2, 2, 2, 2, 2, 2},
-                                     {1, 1, 1, 1, 1, 1, 1, 3, 1, 1, 1, 1, 2, 2, 3, 1, 1, 1, 1, 1, 1, 1, 5, 1, 1, 3, 1, 1},
-                                     {1, 1, 1, 1, 1, 1, 1, 3, 1, 1, 1, 1, 2, 2, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 3, 1, 1},
-                                     {1, 1, 1, 1, 1, 1, 1, 3, 1, 1, 1, 1, 2, 2, 3, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 3, 1, 1},
-                                     {1, 1, 1, 1, 1, 1, 1, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 1, 1, 1, 1, 1, 5, 1, 1, 1, 1},
-                                     {2, 2, 2, 2, 2, 2, 2, 3, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1},
-                                     {1, 1, 1, 1, 5, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1},
-                                     {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1}};
-// 1 = black
-// 2 = red
-// 3 = ladder
-// 4 = passrelle
-// 5 = gold
-// 6 = grey
-
-void create_squares() // this should fill up the list backwards
+// levels are converted from levels/*.txt with tools/level_convert and packed with tools/level_pack
+#define LEVEL_PACK "levels/levels.lrp"
+
+// swaps in the prefetched level and starts loading the one after it, level numbers start at 1
+int next_level(struct LevelStream *stream, int level)
 {
-    square_count = 0;
-    for (unsigned int y = 0; y < 17; y++)
+    if (levelstream_swap(stream) == 0)
     {
-        for (unsigned int x = 0; x < 28; x++)
-        { // counter clockwise construction
-            if (table[y][x] == 2)
-            {
-                all_squares[square_count][0] = (struct Vertex){0xFF0000FF, (0.0f) + (1.0f / 7.9f) * x, (0.0f) + (1.0f / 8.0f) * y, -1.0f};
-                all_squares[square_count][1] = (struct Vertex){0xFF0000FF, (0.0f) + (1.0f / 7.9f) * x, (1.0f / 8.0f) + (1.0f / 8.0f) * y, -1.0f};
-                all_squares[square_count][2] = (struct Vertex){0xFF0000FF, (1.0f / 8.0f) + (1.0f / 7.9f) * x, (1.0f / 8.0f) + (1.0f / 8.0f) * y, -1.0f};
-                all_squares[square_count][3] = (struct Vertex){0xFF0000FF, (1.0f / 8.0f) + (1.0f / 7.9f) * x, 0.0f + (1.0f / 8.0f) * y, -1.0f};
-            }
-            else if (table[y][x] == 1)
-            {
-                all_squares[square_count][0] = (struct Vertex){0xFF000000, (0.0f) + (1.0f / 7.9f) * x, (0.0f) + (1.0f / 8.0f) * y, -1.0f};
-                all_squares[square_count][1] = (struct Vertex){0xFF000000, (0.0f) + (1.0f / 7.9f) * x, (1.0f / 8.0f) + (1.0f / 8.0f) * y, -1.0f};
-                all_squares[square_count][2] = (struct Vertex){0xFF000000, (1.0f / 8.0f) + (1.0f / 7.9f) * x, (1.0f / 8.0f) + (1.0f / 8.0f) * y, -1.0f};
-                all_squares[square_count][3] = (struct Vertex){0xFF000000, (1.0f / 8.0f) + (1.0f / 7.9f) * x, 0.0f + (1.0f / 8.0f) * y, -1.0f};
-            }
-            else if (table[y][x] == 3)
-            {
-                all_squares[square_count][0] = (struct Vertex){0xFF00FFFF, (0.0f) + (1.0f / 7.9f) * x, (0.0f) + (1.0f / 8.0f) * y, -1.0f};
-                all_squares[square_count][1] = (struct Vertex){0xFF00FFFF, (0.0f) + (1.0f / 7.9f) * x, (1.0f / 8.0f) + (1.0f / 8.0f) * y, -1.0f};
-                all_squares[square_count][2] = (struct Vertex){0xFF00FFFF, (1.0f / 8.0f) + (1.0f / 7.9f) * x, (1.0f / 8.0f) + (1.0f / 8.0f) * y, -1.0f};
-                all_squares[square_count][3] = (struct Vertex){0xFF00FFFF, (1.0f / 8.0f) + (1.0f / 7.9f) * x, 0.0f + (1.0f / 8.0f) * y, -1.0f};
-            }
-            else if (table[y][x] == 6)
-            {
-                all_squares[square_count][0] = (struct Vertex){0xFFFFFFFF, (0.0f) + (1.0f / 7.9f) * x, (0.0f) + (1.0f / 8.0f) * y, -1.0f};
-                all_squares[square_count][1] = (struct Vertex){0xFFFFFFFF, (0.0f) + (1.0f / 7.9f) * x, (1.0f / 8.0f) + (1.0f / 8.0f) * y, -1.0f};
-                all_squares[square_count][2] = (struct Vertex){0xFFFFFFFF, (1.0f / 8.0f) + (1.0f / 7.9f) * x, (1.0f / 8.0f) + (1.0f / 8.0f) * y, -1.0f};
-                all_squares[square_count][3] = (struct Vertex){0xFFFFFFFF, (1.0f / 8.0f) + (1.0f / 7.9f) * x, 0.0f + (1.0f / 8.0f) * y, -1.0f};
-            }
-            square_count++;
-        }
+        level++;
+    }
+    else
+    {
+        // no more levels in the pack, start over from the first one
+        level = 1;
+        levelstream_prefetch(stream, level - 1);
+        if (levelstream_swap(stream) < 0)
+            return -1;
     }
+
+    printf("level %d ready %u us after its request (loaded in %u us), the switch waited %u us for it\n",
+           level, stream->ready_us, stream->load_us, stream->stall_us);
+    if (stream->decode_us > 0)
+        printf("decoded %u -> %u bytes in %u us (%u KB/s)\n", stream->pack.packed_size, stream->pack.cell_count,
+               stream->decode_us, stream->pack.cell_count * 1000 / stream->decode_us);
+
+    levelstream_prefetch(stream, level); // pack numbers start at 0, this is the level after this one
+    return level;
+}
+
+// moves the camera with the dpad without leaving the level
+void update_camera(struct Tilemap *map, const SceCtrlData *pad)
+{
+    float x = map->camera_x;
+    float y = map->camera_y;
+
+    if (pad->Buttons & PSP_CTRL_LEFT)
+        x -= TILE_STEP_X;
+    if (pad->Buttons & PSP_CTRL_RIGHT)
+        x += TILE_STEP_X;
+    if (pad->Buttons & PSP_CTRL_DOWN)
+        y -= TILE_STEP_Y;
+    if (pad->Buttons & PSP_CTRL_UP)
+        y += TILE_STEP_Y;
+
+    float max_x = map->width * TILE_STEP_X - VIEW_WORLD_W;
+    float max_y = map->height * TILE_STEP_Y - VIEW_WORLD_H;
+    if (x > max_x)
+        x = max_x;
+    if (y > max_y)
+        y = max_y;
+    if (x < 0.0f)
+        x = 0.0f;
+    if (y < 0.0f)
+        y = 0.0f;
+
+    tilemap_set_camera(map, x, y);
 }
 
 int main()
 {
-    // unsigned int (*tab)[28] = getTable();
     //  Boillerplate
     setup_callbacks(); // home button functionnality
 
@@ -270,15 +239,52 @@ int main()
     initGraphics();
 
     // Initialize Matrices
-    sceGumMatrixMode(GU_PROJECTION); // tell is i am in 2d(ortographic matrix) or 3d(perspective matrix)
-    sceGumLoadIdentity();
-    sceGumOrtho(-16.0f / 9.0f, 16.0f / 9.0f, -1.0f, 1.0f, -10.0f, 10.0f);
+    // the engine matrix stack only uploads matrices that changed, see matrix.h
+    matrix_init();
+
+    matrix_mode(GU_PROJECTION); // tell is i am in 2d(ortographic matrix) or 3d(perspective matrix)
+    matrix_identity();
+    matrix_ortho(-16.0f / 9.0f, 16.0f / 9.0f, -1.0f, 1.0f, -10.0f, 10.0f);
+
+    matrix_mode(GU_VIEW); // camera transformations
+    matrix_identity();
+
+    matrix_mode(GU_MODEL); // positions of current model
+    matrix_identity();
+
+    sceCtrlSetSamplingCycle(0);
+    sceCtrlSetSamplingMode(PSP_CTRL_MODE_ANALOG);
+
+    gpubuffer_init(geometry_vram, GEOMETRY_VRAM_SIZE);
+
+    if (atlas_create() < 0)
+        goto cleanup;
+
+    // backdrop and HUD live across levels, only the playfield layer comes from the level stream
+    struct Layers layers;
+    if (layers_create(&layers) < 0)
+        goto cleanup;
 
-    sceGumMatrixMode(GU_VIEW); // camera transformations
-    sceGumLoadIdentity();
+    // the static playfield tiles are rendered once into a wraparound texture, scrolling only
+    // renders the columns and rows that come into view
+    struct ScrollRing ring;
+    scrollring_create(&ring, ring_vram);
+    layers.ring = &ring;
 
-    sceGumMatrixMode(GU_MODEL); // positions of current model
-    sceGumLoadIdentity();
+    // level geometry is built per chunk and only rebuilt when a cell changes.
+    // the next level is always loading in the background while the current one is played
+    struct LevelStream stream;
+    if (levelstream_start(&stream, LEVEL_PACK) < 0)
+        goto destroy_layers;
+
+    levelstream_prefetch(&stream, 0);
+    int level = next_level(&stream, 0);
+    if (level < 0)
+        goto stop;
+
+    SceCtrlData pad;
+    unsigned int previous_buttons = 0;
+    unsigned int ticks = 0;
 
     // Main program loop
     while (running)
@@ -287,25 +293,40 @@ int main()
         startFrame();
 
         sceGuDisable(GU_DEPTH_TEST);
-        sceGuDisable(GU_TEXTURE_2D);
 
         sceGuClearColor(0xFF000000);
         sceGuClear(GU_COLOR_BUFFER_BIT | GU_DEPTH_BUFFER_BIT);
-        create_squares();
-
-        reset_translate(-16.0f / 9.0f, -1.0f, 0.0f); // important for the placement os the cells
 
-        // reset_translate(-16.0f / 9.0f, -1.0f, 0.0f);
-        // sceGumDrawArray(GU_TRIANGLES, GU_INDEX_16BIT | GU_COLOR_8888 | GU_VERTEX_32BITF | GU_TRANSFORM_3D, 6, square_indices, square_indexed);
-
-        for (int i = 0; i < square_count; i++)
+        sceCtrlPeekBufferPositive(&pad, 1);
+        if ((pad.Buttons & ~previous_buttons) & PSP_CTRL_RTRIGGER)
         {
-            sceGumDrawArray(GU_TRIANGLES, GU_INDEX_16BIT | GU_COLOR_8888 | GU_VERTEX_32BITF | GU_TRANSFORM_3D, 6, square_indices, all_squares[i]);
+            int switched = next_level(&stream, level);
+            if (switched > 0)
+            {
+                level = switched;
+                scrollring_invalidate(&ring); // the two level buffers take turns, the map pointer alone can match
+            }
         }
+        previous_buttons = pad.Buttons;
+
+        update_camera(stream.current, &pad);
+
+        layers.playfield = stream.current;
+        layers_update_hud(&layers);
+        scrollring_update(&ring, stream.current, draw_buffer);
+        layers_draw(&layers, ticks++); // only the chunks in view are drawn
 
         endFrame();
     }
 
+stop:
+    levelstream_stop(&stream);
+
+destroy_layers:
+    layers_destroy(&layers);
+
+cleanup:
+    atlas_destroy();
     termGraphics();
 
     // Exit Game
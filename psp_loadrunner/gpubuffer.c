@@ -0,0 +1,150 @@
+#include "headers/gpubuffer.h"
+
+#include <pspge.h>
+#include <pspkernel.h>
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UNCACHED(p) ((void *)(((unsigned int)(p)) | 0x40000000))
+#define BLOCK_ALIGN (16)
+
+// used parts of the spare EDRAM, sorted by offset. first fit is plenty for a few static meshes
+struct VramBlock
+{
+    unsigned int offset, size;
+};
+
+static unsigned int vram_base = 0; // absolute address of the spare EDRAM
+static unsigned int vram_size = 0;
+static struct VramBlock blocks[GPUBUFFER_MAX_VRAM_BLOCKS];
+static unsigned int block_count = 0;
+
+void gpubuffer_init(void *vram_offset, unsigned int size)
+{
+    vram_base = (unsigned int)vram_offset + (unsigned int)sceGeEdramGetAddr();
+    vram_size = size;
+    block_count = 0;
+}
+
+// returns the offset in the spare EDRAM, or -1
+static int vram_alloc(unsigned int size)
+{
+    size = (size + BLOCK_ALIGN - 1) & ~(BLOCK_ALIGN - 1);
+    if (block_count == GPUBUFFER_MAX_VRAM_BLOCKS)
+        return -1;
+
+    unsigned int start = 0;
+    for (unsigned int i = 0; i <= block_count; i++)
+    {
+        unsigned int end = i < block_count ? blocks[i].offset : vram_size;
+        if (end - start >= size)
+        {
+            memmove(&blocks[i + 1], &blocks[i], (block_count - i) * sizeof(struct VramBlock));
+            blocks[i] = (struct VramBlock){start, size};
+            block_count++;
+            return start;
+        }
+        if (i < block_count)
+            start = blocks[i].offset + blocks[i].size;
+    }
+    return -1;
+}
+
+static void vram_free(unsigned int offset)
+{
+    for (unsigned int i = 0; i < block_count; i++)
+    {
+        if (blocks[i].offset == offset)
+        {
+            block_count--;
+            memmove(&blocks[i], &blocks[i + 1], (block_count - i) * sizeof(struct VramBlock));
+            return;
+        }
+    }
+}
+
+unsigned int gpubuffer_vram_free(void)
+{
+    unsigned int best = 0, start = 0;
+    for (unsigned int i = 0; i <= block_count; i++)
+    {
+        unsigned int end = i < block_count ? blocks[i].offset : vram_size;
+        if (end - start > best)
+            best = end - start;
+        if (i < block_count)
+            start = blocks[i].offset + blocks[i].size;
+    }
+    return best;
+}
+
+int gpubuffer_create(struct GpuBuffer *buffer, unsigned int size, enum BufferPlacement placement)
+{
+    memset(buffer, 0, sizeof(*buffer));
+    buffer->size = size;
+
+    if (placement == BUFFER_VRAM)
+    {
+        int offset = vram_alloc(size);
+        if (offset >= 0)
+        {
+            // the CPU writes EDRAM uncached, nothing to write back later
+            buffer->data = (void *)(vram_base + offset);
+            buffer->cpu = UNCACHED(buffer->data);
+            buffer->placement = BUFFER_VRAM;
+            memset(buffer->cpu, 0, size);
+            return 0;
+        }
+        placement = BUFFER_RAM; // spare EDRAM is full, static data still works from RAM
+    }
+
+    buffer->data = memalign(BLOCK_ALIGN, size);
+    if (!buffer->data)
+        return -1;
+
+    buffer->placement = placement;
+    if (placement == BUFFER_UNCACHED)
+    {
+        // no cached line of the block may be written back over what goes through the mirror
+        sceKernelDcacheWritebackInvalidateRange(buffer->data, size);
+        buffer->cpu = UNCACHED(buffer->data);
+        memset(buffer->cpu, 0, size);
+    }
+    else
+    {
+        buffer->cpu = buffer->data;
+        memset(buffer->cpu, 0, size);
+        sceKernelDcacheWritebackRange(buffer->data, size);
+    }
+    return 0;
+}
+
+void gpubuffer_destroy(struct GpuBuffer *buffer)
+{
+    if (!buffer->data)
+        return;
+
+    if (buffer->placement == BUFFER_VRAM)
+        vram_free((unsigned int)buffer->data - vram_base);
+    else
+        free(buffer->data);
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+void gpubuffer_flush(struct GpuBuffer *buffer, unsigned int offset, unsigned int size)
+{
+    // only cached RAM holds data the GE cannot see yet
+    if (buffer->placement == BUFFER_RAM)
+        sceKernelDcacheWritebackRange((unsigned char *)buffer->data + offset, size);
+}
+
+void gpubuffer_upload(struct GpuBuffer *buffer, unsigned int offset, const void *src, unsigned int size)
+{
+    if (offset >= buffer->size)
+        return;
+    if (size > buffer->size - offset)
+        size = buffer->size - offset;
+
+    memcpy((unsigned char *)buffer->cpu + offset, src, size);
+    gpubuffer_flush(buffer, offset, size);
+}
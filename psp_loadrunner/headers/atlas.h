@@ -0,0 +1,21 @@
+#ifndef ATLAS_INCLUDE
+#define ATLAS_INCLUDE
+
+// the tile art, one cell per tile kind (see the atlas column and row of tiles.h)
+#define ATLAS_CELL (16) // pixels per tile side
+#define ATLAS_COLUMNS (8)
+#define ATLAS_ROWS (4) // the longest tile animation has 4 frames, autotiles have 4 variants
+#define ATLAS_WIDTH (ATLAS_CELL * ATLAS_COLUMNS)
+#define ATLAS_HEIGHT (ATLAS_CELL * ATLAS_ROWS)
+
+// size of one atlas cell in texture coordinates
+#define ATLAS_CELL_U (1.0f / ATLAS_COLUMNS)
+#define ATLAS_CELL_V (1.0f / ATLAS_ROWS)
+
+// paints the tile art into a texture, returns 0 on success
+int atlas_create(void);
+void atlas_destroy(void);
+
+// makes the atlas the current texture with no texture offset
+void atlas_bind(void);
+#endif
@@ -0,0 +1,167 @@
+#ifndef FIXED_INCLUDE
+#define FIXED_INCLUDE
+
+// 16.16 fixed point for the game simulation. integer math gives the same bits on the PSP and in the
+// host tools, floats depend on the FPU, the compiler and libm, and the single FPU is busy with vertices.
+// gameplay positions are in cells (FIXED_ONE is one cell), floats only appear when drawing
+typedef int fixed;
+
+#define FIXED_SHIFT (16)
+#define FIXED_ONE (1 << FIXED_SHIFT)
+#define FIXED_HALF (1 << (FIXED_SHIFT - 1))
+
+// compile time constants like FIXED_CONST(0.25) are exact for values that are multiples of 1/65536
+#define FIXED_CONST(value) ((fixed)((value) * FIXED_ONE + ((value) < 0 ? -0.5 : 0.5)))
+
+static inline fixed fixed_from_int(int value)
+{
+    return value * FIXED_ONE;
+}
+
+// rounds toward minus infinity, so a position gives the cell it is in even left of 0
+static inline int fixed_floor(fixed value)
+{
+    return value >> FIXED_SHIFT;
+}
+
+static inline int fixed_ceil(fixed value)
+{
+    return (value + FIXED_ONE - 1) >> FIXED_SHIFT;
+}
+
+static inline int fixed_round(fixed value)
+{
+    return (value + FIXED_HALF) >> FIXED_SHIFT;
+}
+
+// only for drawing and tools, never feed the result back into the simulation
+static inline float fixed_to_float(fixed value)
+{
+    return value * (1.0f / FIXED_ONE);
+}
+
+static inline fixed fixed_mul(fixed a, fixed b)
+{
+    return (fixed)(((long long)a * b) >> FIXED_SHIFT);
+}
+
+// a 64 bit division, a libgcc call on the PSP. multiply by a constant inverse in hot loops
+static inline fixed fixed_div(fixed a, fixed b)
+{
+    return (fixed)(((long long)a << FIXED_SHIFT) / b);
+}
+
+static inline fixed fixed_abs(fixed value)
+{
+    return value < 0 ? -value : value;
+}
+
+static inline fixed fixed_min(fixed a, fixed b)
+{
+    return a < b ? a : b;
+}
+
+static inline fixed fixed_max(fixed a, fixed b)
+{
+    return a > b ? a : b;
+}
+
+static inline fixed fixed_clamp(fixed value, fixed low, fixed high)
+{
+    return value < low ? low : (value > high ? high : value);
+}
+
+// a + (b - a) * t, t from 0 to FIXED_ONE
+static inline fixed fixed_lerp(fixed a, fixed b, fixed t)
+{
+    return a + fixed_mul(b - a, t);
+}
+
+// moves value toward target by at most step, for accelerations and easing without overshoot
+static inline fixed fixed_approach(fixed value, fixed target, fixed step)
+{
+    if (value < target)
+        return value + step < target ? value + step : target;
+    return value - step > target ? value - step : target;
+}
+
+fixed fixed_sqrt(fixed value);
+
+// angles are binary, FIXED_TURN is a full turn, so they wrap on their own when kept in 16 bits.
+// sin and cos come from a quarter wave table in fixed.c, never from libm
+#define FIXED_TURN (65536)
+#define FIXED_ANGLE(degrees) ((unsigned int)(int)((degrees) * FIXED_TURN / 360) & (FIXED_TURN - 1))
+
+fixed fixed_sin(unsigned int angle);
+fixed fixed_cos(unsigned int angle);
+
+struct FixedVec2
+{
+    fixed x, y;
+};
+
+static inline struct FixedVec2 fixed_vec2(fixed x, fixed y)
+{
+    return (struct FixedVec2){x, y};
+}
+
+static inline struct FixedVec2 fixed_vec2_add(struct FixedVec2 a, struct FixedVec2 b)
+{
+    return (struct FixedVec2){a.x + b.x, a.y + b.y};
+}
+
+static inline struct FixedVec2 fixed_vec2_sub(struct FixedVec2 a, struct FixedVec2 b)
+{
+    return (struct FixedVec2){a.x - b.x, a.y - b.y};
+}
+
+static inline struct FixedVec2 fixed_vec2_scale(struct FixedVec2 v, fixed s)
+{
+    return (struct FixedVec2){fixed_mul(v.x, s), fixed_mul(v.y, s)};
+}
+
+static inline fixed fixed_vec2_dot(struct FixedVec2 a, struct FixedVec2 b)
+{
+    return (fixed)(((long long)a.x * b.x + (long long)a.y * b.y) >> FIXED_SHIFT);
+}
+
+static inline struct FixedVec2 fixed_vec2_lerp(struct FixedVec2 a, struct FixedVec2 b, fixed t)
+{
+    return (struct FixedVec2){fixed_lerp(a.x, b.x, t), fixed_lerp(a.y, b.y, t)};
+}
+
+fixed fixed_vec2_length(struct FixedVec2 v);
+
+// unit vector of an angle, 0 points along +x and a quarter turn along +y
+static inline struct FixedVec2 fixed_vec2_angle(unsigned int angle)
+{
+    return (struct FixedVec2){fixed_cos(angle), fixed_sin(angle)};
+}
+
+// axis aligned box, min inclusive and max exclusive, so boxes that only touch do not overlap
+struct FixedAABB
+{
+    struct FixedVec2 min, max;
+};
+
+static inline struct FixedAABB fixed_aabb(fixed x, fixed y, fixed w, fixed h)
+{
+    return (struct FixedAABB){{x, y}, {x + w, y + h}};
+}
+
+static inline int fixed_aabb_overlap(const struct FixedAABB *a, const struct FixedAABB *b)
+{
+    return a->min.x < b->max.x && b->min.x < a->max.x && a->min.y < b->max.y && b->min.y < a->max.y;
+}
+
+static inline int fixed_aabb_contains(const struct FixedAABB *box, struct FixedVec2 point)
+{
+    return point.x >= box->min.x && point.x < box->max.x && point.y >= box->min.y && point.y < box->max.y;
+}
+
+static inline void fixed_aabb_translate(struct FixedAABB *box, struct FixedVec2 delta)
+{
+    box->min = fixed_vec2_add(box->min, delta);
+    box->max = fixed_vec2_add(box->max, delta);
+}
+#endif
@@ -0,0 +1,39 @@
+#ifndef GPUBUFFER_INCLUDE
+#define GPUBUFFER_INCLUDE
+
+// where the bytes of a buffer live. the GE fetches vertices and indices from main RAM over the same
+// bus the CPU uses, static geometry in spare EDRAM takes that traffic off the bus
+enum BufferPlacement
+{
+    BUFFER_VRAM,     // spare EDRAM from gpubuffer_init, for data uploaded once. falls back to RAM when full
+    BUFFER_RAM,      // cached main RAM, written by the CPU and written back on upload
+    BUFFER_UNCACHED, // main RAM through the uncached mirror, for data rewritten every frame
+};
+
+#define GPUBUFFER_MAX_VRAM_BLOCKS (32)
+
+struct GpuBuffer
+{
+    void *data;         // what the GE reads, pass it to the draw functions of vertex.h
+    void *cpu;          // where the CPU writes, the same memory through the right cache mirror
+    unsigned int size;  // in bytes
+    unsigned char placement; // enum BufferPlacement it ended up in
+};
+
+// hands the EDRAM from vram_offset (VRAM relative, like getStaticVramBuffer returns) to the buffers
+void gpubuffer_init(void *vram_offset, unsigned int size);
+
+// returns 0 on success, the buffer is zeroed. the EDRAM blocks are not locked: create and destroy
+// BUFFER_VRAM buffers on the main thread only. BUFFER_RAM and BUFFER_UNCACHED ones only use the heap
+// and work from any thread
+int gpubuffer_create(struct GpuBuffer *buffer, unsigned int size, enum BufferPlacement placement);
+void gpubuffer_destroy(struct GpuBuffer *buffer);
+
+// copies size bytes to offset in the buffer and makes them visible to the GE
+void gpubuffer_upload(struct GpuBuffer *buffer, unsigned int offset, const void *src, unsigned int size);
+// after the CPU wrote to buffer->cpu directly, makes the range visible to the GE
+void gpubuffer_flush(struct GpuBuffer *buffer, unsigned int offset, unsigned int size);
+
+// EDRAM left for BUFFER_VRAM, in bytes (the biggest free block)
+unsigned int gpubuffer_vram_free(void);
+#endif
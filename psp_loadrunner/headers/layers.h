@@ -0,0 +1,38 @@
+#ifndef LAYERS_INCLUDE
+#define LAYERS_INCLUDE
+
+#include "tilemap.h"
+#include "scrollring.h"
+#include "patch.h"
+
+// the backdrop pattern repeats every BACKDROP_PERIOD cells, so a map one period larger than the
+// screen scrolls forever by wrapping its camera
+#define BACKDROP_PERIOD (4)
+#define BACKDROP_SCROLL (0.5f)
+#define HUD_UPDATE_INTERVAL (30)
+#define HUD_PANEL_COLOR (0xA0402818) // ABGR, the level shows through a bit
+
+// every layer is its own tilemap with its own chunk meshes, so changing the cells of one layer
+// never rebuilds another. they are drawn back to front
+struct Layers
+{
+    struct Tilemap background; // parallax backdrop, never changes once built
+    struct Tilemap *playfield; // the level, owned by the level stream
+    struct Tilemap foreground; // HUD, fixed on screen
+
+    struct ScrollRing *ring; // when set, the static playfield tiles are composited from it
+
+    struct Patch hud_panel;           // rounded backing of the HUD row, tessellated by the GE
+    struct GpuBuffer hud_panel_points; // its control points, built once
+
+    unsigned int hud_gold; // gold count the HUD currently shows
+};
+
+int layers_create(struct Layers *layers);
+void layers_destroy(struct Layers *layers);
+
+// refreshes the HUD from the playfield, cells are only touched when the shown values change
+void layers_update_hud(struct Layers *layers);
+// draws every layer for the camera of the playfield, the ring has to be updated for it first
+void layers_draw(struct Layers *layers, unsigned int ticks);
+#endif
@@ -0,0 +1,80 @@
+#ifndef LEVEL_INCLUDE
+#define LEVEL_INCLUDE
+
+#include "tilegrid.h"
+
+// the loaders are also linked into the host tools, so the file handle type depends on the platform
+#ifdef __PSP__
+#include <pspiofilemgr.h>
+typedef SceUID LevelFile;
+#else
+#include <stdio.h>
+typedef FILE *LevelFile;
+#endif
+
+#define LEVEL_MAGIC "LRLV"
+#define LEVEL_VERSION (1)
+
+// largest level the loader accepts, keeps a corrupted header from asking for megabytes
+#define LEVEL_MAX_SIDE (1024)
+
+// .lvl files are this header followed by width * height cells (one byte each, bottom row first),
+// which is the exact layout of TileGrid.cells so the cells can be read straight into the grid.
+// all the fields are little endian like the PSP
+struct LevelHeader
+{
+    char magic[4];               // LEVEL_MAGIC
+    unsigned short version;      // LEVEL_VERSION
+    unsigned short header_size;  // offset of the cells, lets newer headers grow
+    unsigned short width, height; // in cells
+    unsigned int cell_count;     // width * height
+};
+
+// creates the grid with the size stored in the file and fills it, returns 0 on success
+int level_load(const char *path, struct TileGrid *grid);
+
+#define PACK_MAGIC "LRPK"
+#define PACK_VERSION (1)
+
+// .lrp level packs: this header, the levels' run length encoded cells, then the index table
+// with one PackEntry per level so any level is one seek away
+struct PackHeader
+{
+    char magic[4];              // PACK_MAGIC
+    unsigned short version;     // PACK_VERSION
+    unsigned short header_size; // sizeof(struct PackHeader)
+    unsigned int level_count;
+    unsigned int index_offset; // file offset of level_count PackEntry
+};
+
+struct PackEntry
+{
+    unsigned int offset;      // file offset of the encoded cells
+    unsigned int packed_size; // in bytes, never more than width * height
+    unsigned short width, height;
+};
+
+// cells are encoded as one byte per run: high nibble is the run length - 1, low nibble the tile.
+// every byte makes at least one cell, so decoding can run in place from the end of the grid
+#define PACK_MAX_RUN (16)
+
+struct LevelPack
+{
+    LevelFile file;
+    unsigned int level_count;
+    struct PackEntry *index;
+
+    // stats of the last levelpack_load
+    unsigned int decode_us;
+    unsigned int packed_size, cell_count;
+};
+
+int levelpack_open(const char *path, struct LevelPack *pack);
+void levelpack_close(struct LevelPack *pack);
+// same as level_load for level number of the pack (starting at 0)
+int levelpack_load(struct LevelPack *pack, unsigned int number, struct TileGrid *grid);
+
+// decodes src into dest, returns the number of cells written or -1 if src does not make exactly dest_size cells.
+// dest may overlap the end of src as long as src ends where dest ends
+int level_rle_decode(unsigned char *dest, unsigned int dest_size, const unsigned char *src, unsigned int src_size);
+#endif
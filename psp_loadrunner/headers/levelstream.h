@@ -0,0 +1,51 @@
+#ifndef LEVELSTREAM_INCLUDE
+#define LEVELSTREAM_INCLUDE
+
+#include "tilemap.h"
+#include "level.h"
+
+#include <pspkernel.h>
+
+// loads the next level on a background thread while the current one is played. the loader reads the
+// cells and builds the tilemap, switching to the next one swaps two pointers. the chunk meshes are
+// still built on the main thread when they are first drawn, so the first frame of a level pays for
+// the chunks in view
+struct LevelStream
+{
+    struct Tilemap maps[2];
+    struct Tilemap *current; // the level being played, owned by the main thread
+    struct Tilemap *next;    // owned by the loader thread while a prefetch is pending
+
+    SceUID thread;
+    SceUID request_sema; // signaled by the main thread for every prefetch
+    SceUID done_sema;    // signaled by the loader thread when the prefetch finished
+
+    struct LevelPack pack; // only read by the loader thread once started
+    unsigned int number;   // pack level of the pending prefetch
+    int pending; // a prefetch was requested and levelstream_swap has not consumed it yet
+    int result;  // level_load result of the last prefetch
+    volatile int quit;
+
+    // timings of the last level switch, in microseconds
+    unsigned int request_time;
+    unsigned int done_time;  // when the loader thread finished, set before it signals done_sema
+    unsigned int load_us;    // time the loader thread spent reading and building the level
+    unsigned int decode_us;  // part of load_us spent decompressing the cells
+    unsigned int ready_us;   // from the prefetch request until the loader thread finished
+    unsigned int stall_us;   // time levelstream_swap had to wait for the loader thread
+};
+
+// opens the level pack and starts the loader thread
+int levelstream_start(struct LevelStream *stream, const char *pack_path);
+void levelstream_stop(struct LevelStream *stream);
+
+// starts loading level number of the pack in the background.
+// returns -1 if the previous prefetch was not swapped in yet or the pack has no such level
+int levelstream_prefetch(struct LevelStream *stream, unsigned int number);
+// is the prefetched level ready to be swapped in without waiting
+int levelstream_ready(struct LevelStream *stream);
+// makes the prefetched level current, waits for the loader thread if it is not done yet, and frees
+// the level it replaces: call it between frames, after the last list drawing that level finished.
+// returns -1 if there was no prefetch or the level failed to load, current is unchanged then
+int levelstream_swap(struct LevelStream *stream);
+#endif
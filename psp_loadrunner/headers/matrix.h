@@ -0,0 +1,39 @@
+#ifndef MATRIX_INCLUDE
+#define MATRIX_INCLUDE
+
+#include <psptypes.h>
+
+// replacement for the sceGum matrix stack. the math runs on the VFPU and a matrix only goes to the GE
+// when the top of its stack changed since the last upload, so repeating the same transform every
+// frame costs nothing at draw time. draws have to call matrix_upload and use sceGuDrawArray, the
+// typed draw functions of vertex.h do
+#define MATRIX_STACK_DEPTH (8)
+#define MATRIX_MODE_COUNT (4) // GU_PROJECTION, GU_VIEW, GU_MODEL, GU_TEXTURE
+
+// counters for profiling, reset them whenever
+struct MatrixStats
+{
+    unsigned int uploads; // matrices sent to the GE
+    unsigned int skipped; // dirty matrices that turned out equal to what the GE already has
+};
+
+extern struct MatrixStats matrix_stats;
+
+// every stack back to one identity matrix, the GE is assumed to hold nothing. call after sceGuInit
+void matrix_init(void);
+
+// mode is GU_PROJECTION, GU_VIEW, GU_MODEL or GU_TEXTURE, the other calls act on its top matrix
+void matrix_mode(int mode);
+void matrix_push(void);
+void matrix_pop(void);
+
+void matrix_identity(void);
+void matrix_load(const ScePspFMatrix4 *m);
+void matrix_multiply(const ScePspFMatrix4 *m); // top = top * m
+void matrix_translate(float x, float y, float z);
+void matrix_scale(float x, float y, float z);
+void matrix_ortho(float left, float right, float bottom, float top, float near, float far);
+
+// sends the changed stack tops to the GE, call inside a display list before a 3D draw
+void matrix_upload(void);
+#endif
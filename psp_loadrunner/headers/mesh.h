@@ -0,0 +1,161 @@
+#ifndef MESH_INCLUDE
+#define MESH_INCLUDE
+
+// meshes converted offline (tools/mesh_convert.c) to the exact bytes the GE draws: the vertices are
+// already in the chosen GU vertex type with its padding, quantized, and the indices already in strip
+// order. loading is one read into one block, the header is checked and the draw points into the block
+
+// the loader is also linked into the host tools, so the file handle type depends on the platform
+#ifdef __PSP__
+#include <pspiofilemgr.h>
+typedef SceUID MeshFile;
+#else
+#include <stdio.h>
+typedef FILE *MeshFile;
+#endif
+
+#define MESH_MAGIC "LRMS"
+#define MESH_VERSION (3)
+
+// largest file the loader accepts, keeps a corrupted header from asking for the whole RAM
+#define MESH_MAX_SIZE (4 * 1024 * 1024)
+
+// sizes of the vertex components, the values of the GU_TEXTURE_* / GU_NORMAL_* / GU_VERTEX_* fields
+enum MeshComponent
+{
+    MESH_NONE = 0,
+    MESH_8BIT = 1,
+    MESH_16BIT = 2,
+    MESH_FLOAT = 3,
+};
+
+// color formats, the values of the GU_COLOR_* field
+enum MeshColor
+{
+    MESH_COLOR_NONE = 0,
+    MESH_COLOR_5650 = 4,
+    MESH_COLOR_5551 = 5,
+    MESH_COLOR_4444 = 6,
+    MESH_COLOR_8888 = 7,
+};
+
+// the GU vertex type of a layout, without the index and transform flags. the tools build it on the
+// host where pspgu.h is missing, mesh.c checks it against the GU macros
+#define MESH_VERTEX_TYPE(texture, color, normal, position) ((texture) | (color) << 2 | (normal) << 5 | (position) << 7)
+#define MESH_POSITION_BITS (3 << 7) // the position field of a vertex type, what the bounding box corners have
+
+enum MeshPrim
+{
+    MESH_TRIANGLES = 0, // indexed triangle list
+    MESH_STRIP = 1,     // one indexed strip, the strips of the mesh joined by degenerate triangles (see strip.h)
+};
+
+// .mesh files are this header, the vertices, the 16 bit indices and the 8 corners of the bounding
+// box (positions only, in the position format of the vertices), each block 16 byte aligned from
+// the header so they stay aligned in a 16 byte aligned load. a file with levels of detail is several
+// of these one after the other, the finest first. all the fields are little endian like the PSP.
+// 8 and 16 bit positions and texture coordinates are read by the GE as fractions (1.0 is 128 or 32768),
+// the scale and offset bring them back to model units and texture coordinates
+struct MeshHeader
+{
+    char magic[4];              // MESH_MAGIC
+    unsigned short version;     // MESH_VERSION
+    unsigned short header_size; // sizeof(struct MeshHeader)
+    unsigned int file_size;     // of this level, the next level starts there
+    unsigned int vertex_type;   // MESH_VERTEX_TYPE of the vertices
+    unsigned short vertex_size; // bytes per vertex, padding included
+    unsigned char prim;         // enum MeshPrim
+    unsigned char reserved;
+    unsigned int vertex_count;
+    unsigned int index_count;
+    unsigned int vertex_offset; // offset of the vertices from the header
+    unsigned int index_offset;  // offset of the indices from the header
+    float position_scale[3];    // model position = position_offset + position * position_scale
+    float position_offset[3];
+    float uv_scale[2];          // texture coordinate = uv_offset + uv * uv_scale, what sceGuTexScale / sceGuTexOffset take
+    float uv_offset[2];
+    float radius;               // bounding sphere around the model origin
+    float lod_error;            // how far the vertices of this level of detail are from the model, 0 for the model itself, grows with the level
+    unsigned int bbox_offset;   // offset of the bounding box corners from the header
+};
+
+struct Mesh
+{
+    void *data;                      // the loaded block, freed by mesh_destroy (NULL for the coarser levels of a MeshLod)
+    const struct MeshHeader *header;
+    const void *vertices;
+    const unsigned short *indices;
+    const void *bbox;                // 8 corners
+    unsigned int vertex_flags;       // GU vertex type with the index and transform flags (PSP only, 0 on the host)
+    unsigned int bbox_flags;         // GU vertex type of the corners (PSP only)
+    unsigned int load_us;            // time of the load, open to close
+    unsigned int size;               // bytes read
+};
+
+// reads a .mesh file in one read and checks its header, returns 0 on success. only the finest
+// level of a file with levels of detail is used
+int mesh_load(const char *path, struct Mesh *mesh);
+void mesh_destroy(struct Mesh *mesh);
+
+// bytes of one vertex of a layout, with the padding the GE expects: every component is aligned to
+// the size of its own elements and the vertex to its largest element. the converter writes this layout
+unsigned int mesh_vertex_size(unsigned int vertex_type);
+
+#define MESH_MAX_LODS (4)
+
+// a level is only given up for a coarser one once the coarser one is this much under the allowed
+// error, so an object sitting at the distance where two levels meet does not switch every frame
+#define MESH_LOD_HYSTERESIS (0.25f)
+
+// the levels of detail of a mesh, read from one file with one read. levels[0] owns the loaded block.
+// copies of a loaded MeshLod share its levels and keep their own current level, one per object
+// drawn with it. only the loaded one is destroyed
+struct MeshLod
+{
+    struct Mesh levels[MESH_MAX_LODS];
+    unsigned int count;
+    unsigned int current;   // level picked by the last mesh_lod_select
+    float max_error_pixels; // how far on screen a level may be off the model, 1 by default
+};
+
+// returns 0 on success, a .mesh file without levels gives a chain of 1
+int mesh_lod_load(const char *path, struct MeshLod *lod);
+void mesh_lod_destroy(struct MeshLod *lod);
+
+// picks the coarsest level whose error covers at most max_error_pixels, with pixels_per_unit the
+// pixels one model unit takes on screen where the object is: screen height / 2 / (tan(fovy / 2) * distance)
+// with a perspective, screen height / view height with an orthographic projection. keeps the level
+// of the last call when it is still good enough (see MESH_LOD_HYSTERESIS) and returns the level
+unsigned int mesh_lod_select(struct MeshLod *lod, float pixels_per_unit);
+
+#ifdef __PSP__
+// every mesh draw is wrapped in a GE bounding box test of its corners: when the box is off screen the
+// GE jumps over the draw, a culled mesh costs the 8 corner transforms. the GE decides while it runs
+// the list, so the CPU does not know which ones went. with MESH_COUNT_DRAWN the GE raises a signal
+// inside the box of every mesh it draws to count them. each one costs an interrupt, so it is off unless
+// the build defines it (Drawing_test does, to print the counts)
+#ifndef MESH_COUNT_DRAWN
+#define MESH_COUNT_DRAWN (0)
+#endif
+
+// counters for profiling, reset them whenever
+struct MeshCullStats
+{
+    unsigned int submitted;      // mesh draws put in a list
+    volatile unsigned int drawn; // the ones the GE did not skip, complete once the list finished
+};
+
+extern struct MeshCullStats mesh_cull_stats;
+
+// installs the signal handler that counts mesh_cull_stats.drawn, once after sceGuInit
+void mesh_cull_init(void);
+
+// draws the mesh with the current matrices, its position scale and offset pushed on the model matrix,
+// unless its bounding box is off screen. the texture scale and offset are set when the mesh has
+// texture coordinates
+void mesh_draw(const struct Mesh *mesh);
+
+// draws the level picked by the last mesh_lod_select
+void mesh_lod_draw(const struct MeshLod *lod);
+#endif
+#endif
@@ -0,0 +1,69 @@
+#ifndef PATCH_INCLUDE
+#define PATCH_INCLUDE
+
+#include "vertex.h"
+
+// curved surfaces tessellated by the GE itself: only the control points are built by the CPU and
+// fetched over the bus, the triangles are made inside the GE. a bezier patch is a grid of cubic
+// spans sharing their edge points (3n + 1 points per side), a spline patch is a cubic B-spline
+// (4 or more points per side, every point past the 4th adds a span)
+
+#define PATCH_MAX_SIDE (64) // control points per side, keeps the host evaluator on the stack
+
+enum PatchType
+{
+    PATCH_BEZIER,
+    PATCH_SPLINE,
+};
+
+// whether a spline reaches its first and last control point (fill) or stops short of them like a
+// uniform B-spline (open). same values as GU_FILL_FILL .. GU_OPEN_OPEN
+enum PatchEdge
+{
+    PATCH_FILL_FILL,
+    PATCH_OPEN_FILL,
+    PATCH_FILL_OPEN,
+    PATCH_OPEN_OPEN,
+};
+
+// what the GE makes of the tessellated grid, see sceGuPatchPrim
+enum PatchPrim
+{
+    PATCH_SURFACE,
+    PATCH_WIREFRAME,
+    PATCH_POINTS,
+};
+
+struct Patch
+{
+    const struct PatchVertex *control; // ucount * vcount points, u runs fastest
+    unsigned short ucount, vcount;
+    unsigned char type;               // enum PatchType
+    unsigned char uedge, vedge;       // enum PatchEdge, splines only
+    unsigned char divide_u, divide_v; // segments every span is cut in, the triangle count follows them
+    unsigned char prim;               // enum PatchPrim
+};
+
+// spans of one side, a patch draws 2 * spans_u * divide_u * spans_v * divide_v triangles
+unsigned int patch_spans(const struct Patch *patch, int v_side);
+unsigned int patch_triangles(const struct Patch *patch);
+
+// the point of the surface at s, t (0 .. 1 over the whole patch). position, texture coordinates and
+// color use the same basis. the GE does this in hardware, this is for the tools and for picking
+void patch_evaluate(const struct Patch *patch, float s, float t, struct PatchVertex *out);
+
+// the grid of points the GE makes of the patch, (spans_u * divide_u + 1) * (spans_v * divide_v + 1)
+// of them, u running fastest. for previews on the host (see tools/patch_preview.c)
+void patch_tessellate(const struct Patch *patch, struct PatchVertex *out);
+
+// rounded rectangle as 3 x 3 bezier spans (PATCH_PANEL_SIDE points per side) in the z = 0 plane: the corner
+// spans bend the outline through a quarter circle of the radius, the middle ones are flat
+#define PATCH_PANEL_SIDE (10)
+void patch_rounded_panel(struct Patch *patch, struct PatchVertex *control, float x, float y, float w, float h,
+                         float radius, unsigned int color);
+
+#ifdef __PSP__
+// draws the patch with the current matrices, the divide and primitive settings are only sent when they change
+void patch_draw(const struct Patch *patch);
+#endif
+#endif
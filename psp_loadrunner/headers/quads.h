@@ -0,0 +1,16 @@
+#ifndef QUADS_INCLUDE
+#define QUADS_INCLUDE
+
+// one index list shared by everything drawn as quads: quad i is vertices 4i .. 4i + 3, in the order
+// of square_indices (0, 1, 2, 2, 3, 0). any contiguous array of quads is drawn with one call
+#define QUAD_MAX (16384) // 16 bit indices reach vertex 65535, the last vertex of the last quad
+#define QUAD_DRAW_MAX (65535 / 6) // a GE draw takes at most 65535 indices, bigger arrays take a few draws
+#define QUAD_VRAM_MAX (1024) // the indices of the first quads also sit in EDRAM, every chunk draw fits in them
+
+// fills the index list once, later calls do nothing. call it before the first draw, after gpubuffer_init
+void quads_init(void);
+
+// draws quads from a vertex array of any format, vertex_flags being its GU_*_* flags and a transform
+// flag. the typed prefix_draw_quads3d/2d of vertex.h are the usual way in
+void quads_draw(int vertex_flags, unsigned int vertex_size, unsigned int quads, const void *vertices);
+#endif
@@ -0,0 +1,8 @@
+#ifndef SCREEN_INCLUDE
+#define SCREEN_INCLUDE
+
+// Define PSP Width / Height
+#define PSP_BUF_WIDTH (512)
+#define PSP_SCR_WIDTH (480)  // screen width
+#define PSP_SCR_HEIGHT (272) // screen height
+#endif
@@ -0,0 +1,41 @@
+#ifndef SCROLLRING_INCLUDE
+#define SCROLLRING_INCLUDE
+
+#include "tilemap.h"
+#include "screen.h"
+
+// the ring is a wraparound offscreen texture holding the static tiles of the playfield around the
+// camera. when the camera moves only the newly exposed columns and rows are rendered into it, and the
+// screen is composited from it with GU_REPEAT addressing doing the wrap
+#define RING_SIZE (512) // texels per side, power of two and bigger than the screen plus one tile
+#define RING_PSM (GU_PSM_5551) // 16 bit so it fits in VRAM next to the frame buffers, alpha marks empty cells
+
+// world units to ring texels, the same scale the ortho projection gives on screen
+#define RING_PIXELS_X (PSP_SCR_WIDTH / VIEW_WORLD_W)
+#define RING_PIXELS_Y (PSP_SCR_HEIGHT / VIEW_WORLD_H)
+
+struct ScrollRing
+{
+    void *vram;    // VRAM relative address, what sceGuDrawBufferList wants
+    void *texture; // the same memory as a texture address
+
+    const struct Tilemap *source; // map the ring content comes from
+    unsigned int revision;        // revision of source when the ring was filled
+    int valid;
+    int x0, y0, x1, y1; // cells currently rendered in the ring, inclusive
+    float camera_x, camera_y; // camera of the last update, where scrollring_draw samples from
+
+    unsigned int drawn_tiles; // tiles rasterized by the last scrollring_update
+};
+
+// vram has to hold RING_SIZE x RING_SIZE texels of RING_PSM
+void scrollring_create(struct ScrollRing *ring, void *vram);
+// forces a full redraw on the next update, cell edits of the source map are noticed on their own
+void scrollring_invalidate(struct ScrollRing *ring);
+
+// renders the cells that entered the view of map since the last update into the ring, then
+// draws into framebuffer again. call it inside a display list, before scrollring_draw
+void scrollring_update(struct ScrollRing *ring, const struct Tilemap *map, void *framebuffer);
+// draws the ring to the screen at the camera of the map it was updated with
+void scrollring_draw(struct ScrollRing *ring);
+#endif
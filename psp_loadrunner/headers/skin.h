@@ -0,0 +1,59 @@
+#ifndef SKIN_INCLUDE
+#define SKIN_INCLUDE
+
+#include "vertex.h"
+
+// skinned and morphed meshes blended by the GE. the GE has 8 bone matrices and no bone indices:
+// weight i of a vertex always goes to bone matrix i, so a mesh has one weight per bone and characters
+// with more bones are split into parts of up to 8. morphing keeps every target of a vertex next to
+// the others and the GE mixes them with the morph weights before skinning.
+//
+// the weight and target counts are part of the GU vertex type, so unlike the fixed formats of vertex.h
+// the layout is built per mesh: 8 bit weights (128 is 1.0) padded to 4 bytes, float u, v, float x, y, z
+#define SKIN_MAX_BONES (8)
+#define SKIN_MAX_MORPHS (8)
+
+struct SkinMesh
+{
+    unsigned char bones;         // weights per vertex, 1 .. SKIN_MAX_BONES
+    unsigned char morphs;        // targets per vertex, 1 .. SKIN_MAX_MORPHS, 1 is no morphing
+    unsigned short stride;       // bytes of one target of one vertex
+    unsigned int vertex_count;
+    unsigned int index_count;    // 0 when the vertices are drawn in order
+    int vertex_flags;            // GU vertex type, weights and targets included (PSP only, 0 on the host)
+    unsigned char *vertices;     // vertex_count * morphs * stride bytes
+    unsigned short *indices;     // index_count triangle list indices, or NULL
+};
+
+// bone matrices are column major 4x4 like ScePspFMatrix4, the GE only uses their 4x3 part.
+// morph weights usually add up to 1
+struct SkinPose
+{
+    float bones[SKIN_MAX_BONES][16];
+    float morph[SKIN_MAX_MORPHS];
+};
+
+// returns 0 on success. vertices and indices are zeroed, fill them with skin_set_vertex and the indices array
+int skin_mesh_create(struct SkinMesh *mesh, unsigned int bones, unsigned int morphs, unsigned int vertex_count, unsigned int index_count);
+void skin_mesh_destroy(struct SkinMesh *mesh);
+
+// writes target `morph` of vertex `vertex`. weights has mesh->bones entries, they are normalized to add
+// up to 1 (negative ones count as 0) and rounded to 8 bits so that they still do
+void skin_set_vertex(struct SkinMesh *mesh, unsigned int vertex, unsigned int morph, const float *weights,
+                     float u, float v, float x, float y, float z);
+
+// after writing the vertices and indices, before the first draw
+void skin_mesh_flush(struct SkinMesh *mesh);
+
+// the pose with every bone at identity and only the first morph target
+void skin_pose_identity(struct SkinPose *pose);
+
+// what the GE does, on the CPU: mixes the targets, then blends the bones. writes vertex_count
+// BatchVertex (white) for batch_vertex_draw3d with the mesh indices. reference and fallback of skin_draw
+void skin_cpu(const struct SkinMesh *mesh, const struct SkinPose *pose, struct BatchVertex *out);
+
+#ifdef __PSP__
+// uploads the bone matrices and morph weights of the pose and lets the GE skin the mesh, with the current matrices
+void skin_draw(const struct SkinMesh *mesh, const struct SkinPose *pose);
+#endif
+#endif
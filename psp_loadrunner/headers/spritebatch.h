@@ -0,0 +1,24 @@
+#ifndef SPRITEBATCH_INCLUDE
+#define SPRITEBATCH_INCLUDE
+
+#include "vertex.h"
+
+// sprites as parallel arrays, one per field, so the kernel loads the same field of 4 sprites at once
+struct SpriteArrays
+{
+    const float *x, *y;               // bottom left corner
+    const float *w, *h;               // size
+    const float *u0, *v0, *u1, *v1;   // texture rectangle, v0 is the top row of the sprite
+    const unsigned int *color;        // ABGR
+};
+
+// writes 4 BatchVertex per sprite in the order of the quad indices (quads.h): bottom left, top left,
+// top right, bottom right. transform is a column major 4x4 matrix laid out like ScePspFMatrix4 and
+// only its affine part is applied, NULL keeps the positions as they are. the output is drawn with
+// batch_vertex_draw_quads3d, or batch_vertex_draw_quads2d when the transform already goes to pixels
+void batch_sprites(const struct SpriteArrays *in, unsigned int count, struct BatchVertex *out, const float *transform);
+
+// plain C version of the same thing, batch_sprites uses the VFPU on the PSP and is checked against it
+// (see tools/batch_bench.c)
+void batch_sprites_reference(const struct SpriteArrays *in, unsigned int count, struct BatchVertex *out, const float *transform);
+#endif
@@ -0,0 +1,26 @@
+#ifndef STRIP_INCLUDE
+#define STRIP_INCLUDE
+
+// triangle strips: n triangles in a strip take n + 2 indices where a list takes 3n, and the GE
+// transforms every index it fetches. the strips of a mesh are joined into one by repeating the last
+// index of a strip and the first of the next, the triangles in between have no area and are skipped.
+// the GE has no primitive restart, this is how several strips go in one draw
+
+// worst case length of the strip of a mesh, when no two triangles can be joined
+#define STRIP_MAX_INDICES(triangles) ((triangles) * 6)
+
+// a GE draw takes at most 65535 indices, longer strips are cut at an even position so they keep their winding
+#define STRIP_DRAW_MAX (65534)
+
+// turns an indexed triangle list into a single strip with the same triangles and winding, triangles
+// with a repeated index are dropped. out takes STRIP_MAX_INDICES(triangles) indices. returns the strip
+// length, or -1 when out of memory. greedy and quadratic in the worst case, meant for the tools and
+// load time (see tools/stripify.c), not for every frame
+int strip_build(const unsigned short *indices, unsigned int triangles, unsigned short *out);
+
+#ifdef __PSP__
+// draws an indexed strip of any vertex format, vertex_flags being its GU_*_* flags and a transform
+// flag. the typed prefix_draw_strip3d/2d of vertex.h are the usual way in
+void strip_draw(int vertex_flags, unsigned int count, const unsigned short *indices, const void *vertices);
+#endif
+#endif
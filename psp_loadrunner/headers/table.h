@@ -1,6 +0,0 @@
-#ifndef TABLE_INCLUDE
-#define TABLE_INCLUDE
-
-/* Your function statement here */
-unsigned int (*getTable(void))[28];
-#endif
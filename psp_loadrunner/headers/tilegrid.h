@@ -0,0 +1,89 @@
+#ifndef TILEGRID_INCLUDE
+#define TILEGRID_INCLUDE
+
+#include "tiles.h"
+#include "fixed.h"
+
+struct TileGrid
+{
+    unsigned int width, height; // in cells, row 0 is the bottom of the level
+    unsigned int words_per_row; // 32 cells per mask word
+    unsigned char *cells;       // width * height tile values
+    unsigned char *neighbors;   // width * height enum Neighbor masks, kept up to date with the cells
+    unsigned int *masks[MASK_COUNT]; // height * words_per_row words each
+};
+
+int tilegrid_create(struct TileGrid *grid, unsigned int width, unsigned int height);
+void tilegrid_destroy(struct TileGrid *grid);
+
+void tilegrid_set(struct TileGrid *grid, unsigned int x, unsigned int y, unsigned char value);
+// recomputes the bitboards and the neighbor masks from the cells, after loading a level
+void tilegrid_rebuild_masks(struct TileGrid *grid);
+
+// sides of a box that hit something in tilegrid_move_box
+enum MoveHit
+{
+    HIT_LEFT = 1,
+    HIT_RIGHT = 2,
+    HIT_DOWN = 4, // standing on something
+    HIT_UP = 8,
+};
+
+// moves a box (in cells, see fixed.h) by delta, x first then y, stopping flush against the cells of mask.
+// returns the enum MoveHit sides that were stopped. the simulation stays in integers, so the same moves
+// end in the same place on the PSP and in the host tools
+int tilegrid_move_box(const struct TileGrid *grid, enum TileMask mask, struct FixedAABB *box, struct FixedVec2 delta);
+
+static inline unsigned char tilegrid_get(const struct TileGrid *grid, unsigned int x, unsigned int y)
+{
+    if (x >= grid->width || y >= grid->height)
+        return TILE_NONE;
+    return grid->cells[y * grid->width + x];
+}
+
+static inline int tilegrid_test(const struct TileGrid *grid, enum TileMask mask, unsigned int x, unsigned int y)
+{
+    if (x >= grid->width || y >= grid->height)
+        return 0;
+    return (grid->masks[mask][y * grid->words_per_row + (x >> 5)] >> (x & 31)) & 1;
+}
+
+// count bits of a mask row starting at cell x, count has to be 32 or less
+static inline unsigned int tilegrid_row_bits(const struct TileGrid *grid, enum TileMask mask, unsigned int x, unsigned int y, unsigned int count)
+{
+    unsigned int word = x >> 5;
+    if (y >= grid->height || word >= grid->words_per_row || count == 0)
+        return 0;
+
+    const unsigned int *row = grid->masks[mask] + y * grid->words_per_row;
+    unsigned int shift = x & 31;
+
+    unsigned int bits = row[word] >> shift;
+    if (shift && word + 1 < grid->words_per_row)
+        bits |= row[word + 1] << (32 - shift);
+
+    if (count < 32)
+        bits &= (1u << count) - 1;
+    return bits;
+}
+
+// is any of the cells x .. x + count - 1 of row y in the mask, cells outside of the level never are.
+// a 3 cell query like "is anything solid below the player" is one shift and one and
+static inline int tilegrid_any(const struct TileGrid *grid, enum TileMask mask, int x, int y, int count)
+{
+    if (x < 0)
+    {
+        count += x;
+        x = 0;
+    }
+    if (y < 0)
+        return 0;
+
+    for (; count > 0; x += 32, count -= 32)
+    {
+        if (tilegrid_row_bits(grid, mask, x, y, count < 32 ? count : 32))
+            return 1;
+    }
+    return 0;
+}
+#endif
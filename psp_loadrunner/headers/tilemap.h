@@ -0,0 +1,81 @@
+#ifndef TILEMAP_INCLUDE
+#define TILEMAP_INCLUDE
+
+#include "vertex.h"
+#include "tilegrid.h"
+#include "gpubuffer.h"
+
+// chunk layout, every chunk owns CHUNK_SIZE x CHUNK_SIZE cells
+#define CHUNK_SIZE (16)
+#define CHUNK_CELLS (CHUNK_SIZE * CHUNK_SIZE)
+
+// how many chunk meshes can be cached at once. the screen shows at most 3x2 chunks,
+// so this only has to cover the view plus the chunks entering it while scrolling
+#define TILEMAP_MAX_MESHES (9)
+
+// size of one cell in world units (same spacing create_squares used)
+#define TILE_SIZE (1.0f / 8.0f)
+#define TILE_STEP_X (1.0f / 7.9f)
+#define TILE_STEP_Y (1.0f / 8.0f)
+#define CHUNK_WORLD_W (CHUNK_SIZE * TILE_STEP_X)
+#define CHUNK_WORLD_H (CHUNK_SIZE * TILE_STEP_Y)
+
+// visible area of the ortho projection set up in main
+#define VIEW_WORLD_W (32.0f / 9.0f)
+#define VIEW_WORLD_H (2.0f)
+
+// quads are grouped by animation: group 0 holds every static tile, animated tiles get the group
+// of their tile value so a whole group is drawn with one texture offset
+struct ChunkMesh
+{
+    struct TileVertex __attribute__((aligned(16))) vertices[CHUNK_CELLS * 4];
+    unsigned short group_start[TILE_TABLE_SIZE]; // first quad of every group
+    unsigned short group_count[TILE_TABLE_SIZE];
+    int quad_count;
+    int owner; // chunk index using this mesh, -1 if free
+};
+
+struct Tilemap
+{
+    unsigned int width, height;     // in cells, row 0 is the bottom of the level
+    unsigned int chunks_x, chunks_y; // in chunks
+    struct TileGrid grid;           // tile values and their bitboards, shared with the game logic
+
+    short *chunk_mesh;           // mesh slot of every chunk, -1 if not resident
+    unsigned char *chunk_dirty;  // set when a cell of the chunk changed since its mesh was built
+    struct ChunkMesh *meshes;    // mesh_count slots, the CPU side of mesh_buffer
+    struct GpuBuffer mesh_buffer; // RAM by default, see tilemap_place_meshes
+    unsigned int mesh_count;     // TILEMAP_MAX_MESHES, or less for maps with fewer chunks
+
+    float camera_x, camera_y; // bottom left corner of the view in world units
+
+    // layer settings, see layers.h. defaults are those of the playfield
+    float scroll_factor;         // how fast the map moves with the camera passed to tilemap_follow
+    float wrap_w, wrap_h;        // the camera wraps at these periods (world units) when they are not 0
+    unsigned int update_interval; // frames between rebuilds of changed chunks and animation steps
+    int draw_static;              // 0 when static tiles come from somewhere else (scrollring.h),
+                                  // only animated groups are drawn then
+
+    unsigned int revision; // bumped on every cell change, lets caches of the cells notice edits
+
+    unsigned int drawn_chunks; // chunks submitted by the last tilemap_draw
+};
+
+int tilemap_create(struct Tilemap *map, unsigned int width, unsigned int height);
+// builds the tilemap around an already filled grid (see level_load), the grid is moved into the map
+int tilemap_create_from_grid(struct Tilemap *map, struct TileGrid *grid);
+void tilemap_destroy(struct Tilemap *map);
+// moves the chunk meshes to another placement (see gpubuffer.h), they are rebuilt on the next draw.
+// maps that never change after being built can keep their meshes in EDRAM. main thread only
+int tilemap_place_meshes(struct Tilemap *map, enum BufferPlacement placement);
+
+unsigned char tilemap_get_cell(const struct Tilemap *map, unsigned int x, unsigned int y);
+void tilemap_set_cell(struct Tilemap *map, unsigned int x, unsigned int y, unsigned char value);
+
+void tilemap_set_camera(struct Tilemap *map, float x, float y);
+// places the camera of a layer from the main camera, applying its scroll factor and wrap
+void tilemap_follow(struct Tilemap *map, float x, float y);
+// ticks drive the tile animations, one tick per frame. a layer steps them on its update frames only,
+// animation frames shorter than its update_interval last one interval
+void tilemap_draw(struct Tilemap *map, unsigned int ticks);
+#endif
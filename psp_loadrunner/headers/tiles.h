@@ -0,0 +1,118 @@
+#ifndef TILES_INCLUDE
+#define TILES_INCLUDE
+
+// every tile kind is described once here, the renderer, the level grid masks and the level tools
+// all read the generated table instead of testing tile values themselves
+
+// one bitboard per property, bit x of a row is set when cell x has the property
+enum TileMask
+{
+    MASK_SOLID,
+    MASK_LADDER,
+    MASK_BAR,
+    MASK_GOLD,
+    MASK_DIGGABLE,
+    MASK_COUNT
+};
+
+// tile flags are the mask bits, so a tile's flags are also the masks it belongs to
+#define TILE_SOLID (1 << MASK_SOLID)
+#define TILE_CLIMBABLE (1 << MASK_LADDER)
+#define TILE_HANGABLE (1 << MASK_BAR)
+#define TILE_COLLECTIBLE (1 << MASK_GOLD)
+#define TILE_DIGGABLE (1 << MASK_DIGGABLE)
+
+enum TileLayer
+{
+    LAYER_NONE, // nothing to draw (black is the clear color)
+    LAYER_BACKGROUND,
+    LAYER_PLAYFIELD,
+    LAYER_FOREGROUND,
+    LAYER_COUNT
+};
+
+// autotiles pick one of AUTOTILE_VARIANTS atlas rows from their neighbors (see tile_variant), the
+// variants sit below the atlas cell like animation frames do, so a tile is either animated or an autotile
+enum Autotile
+{
+    AUTOTILE_NONE,
+    AUTOTILE_ROW,    // runs along x, the ends of a run get caps
+    AUTOTILE_COLUMN, // runs along y, the ends of a run get caps
+};
+
+#define AUTOTILE_VARIANTS (4)
+
+// X(name, value, text character, color, atlas column, atlas row, flags, layer, frames, ticks per frame, autotile)
+// animated tiles have their frames one atlas row below the other, starting at the atlas cell
+#define TILE_LIST(X)                                                                                         \
+    X(NONE, 0, '\0', 0x00000000, 0, 0, 0, LAYER_NONE, 1, 0, AUTOTILE_NONE)                                  \
+    X(EMPTY, 1, '.', 0xFF000000, 0, 0, 0, LAYER_NONE, 1, 0, AUTOTILE_NONE)                                  \
+    X(BRICK, 2, '#', 0xFF0000FF, 1, 0, TILE_SOLID | TILE_DIGGABLE, LAYER_PLAYFIELD, 1, 0, AUTOTILE_ROW)     \
+    X(LADDER, 3, 'H', 0xFF00FFFF, 2, 0, TILE_CLIMBABLE, LAYER_PLAYFIELD, 1, 0, AUTOTILE_COLUMN)             \
+    X(BAR, 4, '-', 0x00000000, 3, 0, TILE_HANGABLE, LAYER_NONE, 1, 0, AUTOTILE_NONE)                        \
+    X(GOLD, 5, '$', 0xFF00D7FF, 4, 0, TILE_COLLECTIBLE, LAYER_PLAYFIELD, 4, 8, AUTOTILE_NONE)               \
+    X(CONCRETE, 6, '@', 0xFFFFFFFF, 5, 0, TILE_SOLID, LAYER_PLAYFIELD, 1, 0, AUTOTILE_NONE)                 \
+    X(BACKDROP, 7, '%', 0xFF402010, 6, 0, 0, LAYER_BACKGROUND, 1, 0, AUTOTILE_NONE)
+
+#define TILE_ENUM(name, value, ch, color, u, v, flags, layer, frames, ticks, autotile) TILE_##name = value,
+enum TileType
+{
+    TILE_LIST(TILE_ENUM)
+};
+#undef TILE_ENUM
+
+// tile values are nibbles (see the level pack), so masking the value keeps every lookup in the table
+#define TILE_TABLE_SIZE (16)
+#define TILE_INDEX(tile) ((tile) & (TILE_TABLE_SIZE - 1))
+
+struct TileProperties
+{
+    unsigned int color;  // ABGR base color the atlas art is painted with
+    unsigned char u, v;  // cell of the tile in the tile atlas
+    unsigned char flags; // TILE_SOLID, TILE_CLIMBABLE, ...
+    unsigned char layer; // enum TileLayer
+    char ch;             // character used in the text level layouts
+    unsigned char frames; // animation frames, 1 for static tiles
+    unsigned char ticks;  // frames of the game (60 per second) each animation frame is shown
+    unsigned char autotile; // enum Autotile
+};
+
+#define TILE_ENTRY(name, value, ch, color, u, v, flags, layer, frames, ticks, autotile) [value] = {color, u, v, flags, layer, ch, frames, ticks, autotile},
+static const struct TileProperties tile_properties[TILE_TABLE_SIZE] = {
+    TILE_LIST(TILE_ENTRY)};
+#undef TILE_ENTRY
+
+static inline const struct TileProperties *tile_props(unsigned char tile)
+{
+    return &tile_properties[TILE_INDEX(tile)];
+}
+
+// the 8 neighbors of a cell, a bit is set when the neighbor holds the same tile (see TileGrid.neighbors).
+// y points up like the level rows
+enum Neighbor
+{
+    NEIGHBOR_N = 1 << 0,
+    NEIGHBOR_NE = 1 << 1,
+    NEIGHBOR_E = 1 << 2,
+    NEIGHBOR_SE = 1 << 3,
+    NEIGHBOR_S = 1 << 4,
+    NEIGHBOR_SW = 1 << 5,
+    NEIGHBOR_W = 1 << 6,
+    NEIGHBOR_NW = 1 << 7,
+};
+
+// atlas row offset of a tile from its neighbor mask: 0 inside a run, 1 at its start (left or bottom),
+// 2 at its end (right or top), 3 when the tile is alone
+static inline unsigned int tile_variant(const struct TileProperties *tile, unsigned char neighbors)
+{
+    switch (tile->autotile)
+    {
+    case AUTOTILE_ROW:
+        return ((neighbors & NEIGHBOR_W) ? 0 : 1) | ((neighbors & NEIGHBOR_E) ? 0 : 2);
+    case AUTOTILE_COLUMN:
+        return ((neighbors & NEIGHBOR_S) ? 0 : 1) | ((neighbors & NEIGHBOR_N) ? 0 : 2);
+    default:
+        return 0;
+    }
+}
+#endif
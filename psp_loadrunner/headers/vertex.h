@@ -0,0 +1,139 @@
+#ifndef VERTEX_INCLUDE
+#define VERTEX_INCLUDE
+
+// the structs and converters also build on the host for the tools, the GU side only on the PSP
+#ifdef __PSP__
+#include <pspgu.h>
+
+#include "matrix.h"
+#include "quads.h"
+#include "strip.h"
+#endif
+
+// vertices are fetched by the GE straight from RAM every frame, so they use the smallest formats
+// the content allows. with GU_TRANSFORM_3D the GE reads 8 bit values as fractions of 128 and
+// 16 bit values as fractions of 32768, through mode (GU_TRANSFORM_2D) takes them as plain pixels/texels
+
+// 16 bit positions cover -VERTEX_POS16_RANGE .. VERTEX_POS16_RANGE world units, the model matrix
+// scales them back with matrix_scale by VERTEX_POS16_RANGE (a chunk is about 2 units wide)
+#define VERTEX_POS16_RANGE (4.0f)
+
+// members and GU flag of every vertex component. the GE pads each component to its own size and the
+// vertex to its biggest component, the same rules C uses for the struct, so the layouts always agree
+#define VC_NONE_MEMBERS
+#define VC_NONE_FLAG 0
+#define VC_TEXTURE_8BIT_MEMBERS unsigned char u, v;
+#define VC_TEXTURE_8BIT_FLAG GU_TEXTURE_8BIT
+#define VC_TEXTURE_16BIT_MEMBERS short u, v;
+#define VC_TEXTURE_16BIT_FLAG GU_TEXTURE_16BIT
+#define VC_TEXTURE_32BITF_MEMBERS float u, v;
+#define VC_TEXTURE_32BITF_FLAG GU_TEXTURE_32BITF
+#define VC_COLOR_4444_MEMBERS unsigned short color;
+#define VC_COLOR_4444_FLAG GU_COLOR_4444
+#define VC_COLOR_5650_MEMBERS unsigned short color;
+#define VC_COLOR_5650_FLAG GU_COLOR_5650
+#define VC_COLOR_8888_MEMBERS unsigned int color;
+#define VC_COLOR_8888_FLAG GU_COLOR_8888
+#define VC_VERTEX_16BIT_MEMBERS short x, y, z;
+#define VC_VERTEX_16BIT_FLAG GU_VERTEX_16BIT
+#define VC_VERTEX_32BITF_MEMBERS float x, y, z;
+#define VC_VERTEX_32BITF_FLAG GU_VERTEX_32BITF
+
+// X(struct name, function prefix, flags name, texture, color, position, size in bytes)
+// every format gets its struct, its GU vertex type flags, a size check and typed draw functions.
+// changing the components of a line changes all of them together
+#define VERTEX_FORMAT_LIST(X)                                                                       \
+    X(TileVertex, tile_vertex, TILE_VERTEX_FLAGS, TEXTURE_8BIT, NONE, VERTEX_16BIT, 8)              \
+    X(SpriteVertex, sprite_vertex, SPRITE_VERTEX_FLAGS, TEXTURE_16BIT, NONE, VERTEX_16BIT, 10)      \
+    X(FillVertex, fill_vertex, FILL_VERTEX_FLAGS, NONE, COLOR_4444, VERTEX_16BIT, 8)                \
+    X(BatchVertex, batch_vertex, BATCH_VERTEX_FLAGS, TEXTURE_32BITF, COLOR_8888, VERTEX_32BITF, 24) \
+    X(PatchVertex, patch_vertex, PATCH_VERTEX_FLAGS, TEXTURE_32BITF, COLOR_8888, VERTEX_32BITF, 24)
+
+// TileVertex: chunk meshes, 8 bit texture coordinates step by 1/128 and atlas cells are multiples of that
+// SpriteVertex: through mode textured sprite corners in texels and pixels
+// FillVertex: through mode flat colored corners
+// BatchVertex: output of the sprite batch kernels (spritebatch.h), floats are what the VFPU writes
+// PatchVertex: control points of the GE tessellated surfaces (patch.h), there are few of them
+
+#define VERTEX_STRUCT(name, prefix, flags, texture, color, position, size) \
+    struct name                                                             \
+    {                                                                       \
+        VC_##texture##_MEMBERS                                              \
+        VC_##color##_MEMBERS                                                \
+        VC_##position##_MEMBERS                                             \
+    };                                                                      \
+    _Static_assert(sizeof(struct name) == size, #name " is not " #size " bytes");
+VERTEX_FORMAT_LIST(VERTEX_STRUCT)
+#undef VERTEX_STRUCT
+
+#ifdef __PSP__
+#define VERTEX_FLAGS(name, prefix, flags, texture, color, position, size) \
+    flags = VC_##texture##_FLAG | VC_##color##_FLAG | VC_##position##_FLAG,
+enum VertexFlags
+{
+    VERTEX_FORMAT_LIST(VERTEX_FLAGS)
+};
+#undef VERTEX_FLAGS
+
+// prefix_draw3d goes through the matrix stack of matrix.h, prefix_draw2d is through mode. indices are 16 bit or NULL.
+// prefix_draw_quads3d/2d draw an array of quads with the shared index list of quads.h,
+// prefix_draw_strip3d/2d an indexed strip of strip.h, split in several draws when it is too long
+#define VERTEX_DRAW(name, prefix, flags, texture, color, position, size)                                         \
+    static inline void prefix##_draw3d(int prim, int count, const unsigned short *indices, const struct name *vertices) \
+    {                                                                                                             \
+        matrix_upload();                                                                                          \
+        sceGuDrawArray(prim, flags | (indices ? GU_INDEX_16BIT : 0) | GU_TRANSFORM_3D, count, indices, vertices);  \
+    }                                                                                                             \
+    static inline void prefix##_draw2d(int prim, int count, const unsigned short *indices, const struct name *vertices) \
+    {                                                                                                             \
+        sceGuDrawArray(prim, flags | (indices ? GU_INDEX_16BIT : 0) | GU_TRANSFORM_2D, count, indices, vertices); \
+    }                                                                                                             \
+    static inline void prefix##_draw_quads3d(unsigned int quads, const struct name *vertices)                    \
+    {                                                                                                             \
+        quads_draw(flags | GU_TRANSFORM_3D, sizeof(struct name), quads, vertices);                               \
+    }                                                                                                             \
+    static inline void prefix##_draw_quads2d(unsigned int quads, const struct name *vertices)                    \
+    {                                                                                                             \
+        quads_draw(flags | GU_TRANSFORM_2D, sizeof(struct name), quads, vertices);                               \
+    }                                                                                                             \
+    static inline void prefix##_draw_strip3d(unsigned int count, const unsigned short *indices, const struct name *vertices) \
+    {                                                                                                             \
+        strip_draw(flags | GU_TRANSFORM_3D, count, indices, vertices);                                           \
+    }                                                                                                             \
+    static inline void prefix##_draw_strip2d(unsigned int count, const unsigned short *indices, const struct name *vertices) \
+    {                                                                                                             \
+        strip_draw(flags | GU_TRANSFORM_2D, count, indices, vertices);                                           \
+    }
+VERTEX_FORMAT_LIST(VERTEX_DRAW)
+#undef VERTEX_DRAW
+#endif
+
+// world units to a 16 bit position, see VERTEX_POS16_RANGE
+static inline short vertex_pos16(float value)
+{
+    float scaled = value * (32767.0f / VERTEX_POS16_RANGE);
+    if (scaled > 32767.0f)
+        return 32767;
+    if (scaled < -32768.0f)
+        return -32768;
+    return (short)(scaled < 0.0f ? scaled - 0.5f : scaled + 0.5f);
+}
+
+// texture coordinate (0 .. 1.99) to 8 bit
+static inline unsigned char vertex_uv8(float value)
+{
+    float scaled = value * 128.0f + 0.5f;
+    return scaled > 255.0f ? 255 : (unsigned char)scaled;
+}
+
+// ABGR 8888 colors, as used everywhere else, to the 16 bit vertex color formats
+static inline unsigned short color_to_4444(unsigned int color)
+{
+    return ((color >> 4) & 0x000F) | ((color >> 8) & 0x00F0) | ((color >> 12) & 0x0F00) | ((color >> 16) & 0xF000);
+}
+
+static inline unsigned short color_to_5650(unsigned int color)
+{
+    return ((color >> 3) & 0x001F) | ((color >> 5) & 0x07E0) | ((color >> 8) & 0xF800);
+}
+#endif
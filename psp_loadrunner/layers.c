@@ -0,0 +1,131 @@
+#include "headers/layers.h"
+#include "headers/matrix.h"
+
+#include <pspgu.h>
+#include <stdlib.h>
+
+#define SCREEN_CELLS_X ((unsigned int)(VIEW_WORLD_W / TILE_STEP_X) + 1)
+#define SCREEN_CELLS_Y ((unsigned int)(VIEW_WORLD_H / TILE_STEP_Y) + 1)
+
+int layers_create(struct Layers *layers)
+{
+    layers->playfield = NULL;
+    layers->ring = NULL;
+    layers->hud_gold = 0;
+
+    // backdrop: dark panels in a checker pattern, one period bigger than the screen
+    unsigned int w = SCREEN_CELLS_X + BACKDROP_PERIOD;
+    unsigned int h = SCREEN_CELLS_Y + BACKDROP_PERIOD;
+    if (tilemap_create(&layers->background, w, h) < 0)
+        return -1;
+
+    for (unsigned int y = 0; y < h; y++)
+        for (unsigned int x = 0; x < w; x++)
+            if (((x / (BACKDROP_PERIOD / 2)) + (y / (BACKDROP_PERIOD / 2))) % 2 == 0)
+                tilemap_set_cell(&layers->background, x, y, TILE_BACKDROP);
+
+    layers->background.scroll_factor = BACKDROP_SCROLL;
+    layers->background.wrap_w = BACKDROP_PERIOD * TILE_STEP_X;
+    layers->background.wrap_h = BACKDROP_PERIOD * TILE_STEP_Y;
+    layers->background.update_interval = 0; // built once, never changes
+
+    // so its meshes can stay in EDRAM, the GE then never fetches them over the bus
+    tilemap_place_meshes(&layers->background, BUFFER_VRAM);
+
+    // HUD: a screen sized map that does not scroll, only refreshed a couple of times per second
+    // its top row is the top row of the screen
+    if (tilemap_create(&layers->foreground, SCREEN_CELLS_X, (unsigned int)(VIEW_WORLD_H / TILE_STEP_Y)) < 0)
+    {
+        tilemap_destroy(&layers->background);
+        return -1;
+    }
+
+    layers->foreground.scroll_factor = 0.0f;
+    layers->foreground.update_interval = HUD_UPDATE_INTERVAL;
+
+    // the panel behind the HUD row is 100 control points, the GE makes the rounded corners out of them
+    if (gpubuffer_create(&layers->hud_panel_points, PATCH_PANEL_SIDE * PATCH_PANEL_SIDE * sizeof(struct PatchVertex), BUFFER_VRAM) < 0)
+    {
+        tilemap_destroy(&layers->background);
+        tilemap_destroy(&layers->foreground);
+        return -1;
+    }
+
+    float row_y = (layers->foreground.height - 1) * TILE_STEP_Y;
+    patch_rounded_panel(&layers->hud_panel, (struct PatchVertex *)layers->hud_panel_points.cpu, 0.02f, row_y - 0.02f,
+                        VIEW_WORLD_W - 0.04f, VIEW_WORLD_H - row_y, 0.06f, HUD_PANEL_COLOR);
+    gpubuffer_flush(&layers->hud_panel_points, 0, layers->hud_panel_points.size);
+    layers->hud_panel.control = (const struct PatchVertex *)layers->hud_panel_points.data; // the GE side of the points
+    return 0;
+}
+
+void layers_destroy(struct Layers *layers)
+{
+    tilemap_destroy(&layers->background);
+    tilemap_destroy(&layers->foreground);
+    gpubuffer_destroy(&layers->hud_panel_points);
+    layers->playfield = NULL;
+}
+
+static unsigned int count_bits(unsigned int bits)
+{
+    unsigned int count = 0;
+    for (; bits; bits &= bits - 1)
+        count++;
+    return count;
+}
+
+void layers_update_hud(struct Layers *layers)
+{
+    if (!layers->playfield)
+        return;
+
+    // gold left in the level, straight from the gold bitboard
+    const struct TileGrid *grid = &layers->playfield->grid;
+    unsigned int gold = 0;
+    for (unsigned int i = 0; i < grid->words_per_row * grid->height; i++)
+        gold += count_bits(grid->masks[MASK_GOLD][i]);
+
+    if (gold == layers->hud_gold)
+        return;
+    layers->hud_gold = gold;
+
+    // one gold icon per piece left along the top row of the screen
+    struct Tilemap *hud = &layers->foreground;
+    for (unsigned int x = 0; x < hud->width; x++)
+        tilemap_set_cell(hud, x, hud->height - 1, x < gold ? TILE_GOLD : TILE_EMPTY);
+}
+
+void layers_draw(struct Layers *layers, unsigned int ticks)
+{
+    if (!layers->playfield)
+        return;
+
+    float x = layers->playfield->camera_x;
+    float y = layers->playfield->camera_y;
+
+    tilemap_follow(&layers->background, x, y);
+    tilemap_draw(&layers->background, ticks);
+
+    // with a ring only the animated tiles of the playfield still come from its chunk meshes
+    layers->playfield->draw_static = layers->ring == NULL;
+    if (layers->ring)
+        scrollring_draw(layers->ring);
+    tilemap_draw(layers->playfield, ticks);
+
+    // HUD panel, in screen units from the bottom left corner like the HUD map
+    matrix_mode(GU_MODEL);
+    matrix_identity();
+    matrix_translate(-16.0f / 9.0f, -1.0f, 0.0f);
+    sceGuDisable(GU_TEXTURE_2D);
+    sceGuDisable(GU_CULL_FACE); // flat and always facing the camera, the winding of the GE strips does not matter
+    sceGuEnable(GU_BLEND);
+    sceGuBlendFunc(GU_ADD, GU_SRC_ALPHA, GU_ONE_MINUS_SRC_ALPHA, 0, 0);
+    patch_draw(&layers->hud_panel);
+    sceGuDisable(GU_BLEND);
+    sceGuEnable(GU_CULL_FACE);
+    sceGuEnable(GU_TEXTURE_2D);
+
+    tilemap_follow(&layers->foreground, x, y);
+    tilemap_draw(&layers->foreground, ticks);
+}
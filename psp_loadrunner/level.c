@@ -0,0 +1,215 @@
+#include "headers/level.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// file access and timing for the PSP and for the host tools
+#ifdef __PSP__
+#include <pspthreadman.h>
+
+#define LEVEL_FILE_OK(f) ((f) >= 0)
+#define LEVEL_NO_FILE (-1)
+
+static unsigned int time_us()
+{
+    return sceKernelGetSystemTimeLow();
+}
+
+static LevelFile file_open(const char *path)
+{
+    return sceIoOpen(path, PSP_O_RDONLY, 0777);
+}
+
+static int file_read(LevelFile f, void *dest, unsigned int size)
+{
+    return sceIoRead(f, dest, size);
+}
+
+static int file_seek(LevelFile f, unsigned int offset)
+{
+    return sceIoLseek32(f, offset, PSP_SEEK_SET) == (int)offset ? 0 : -1;
+}
+
+static void file_close(LevelFile f)
+{
+    sceIoClose(f);
+}
+#else
+#include <time.h>
+
+#define LEVEL_FILE_OK(f) ((f) != NULL)
+#define LEVEL_NO_FILE (NULL)
+
+static unsigned int time_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned int)(ts.tv_sec * 1000000ull + ts.tv_nsec / 1000);
+}
+
+static LevelFile file_open(const char *path)
+{
+    return fopen(path, "rb");
+}
+
+static int file_read(LevelFile f, void *dest, unsigned int size)
+{
+    return (int)fread(dest, 1, size, f);
+}
+
+static int file_seek(LevelFile f, unsigned int offset)
+{
+    return fseek(f, offset, SEEK_SET);
+}
+
+static void file_close(LevelFile f)
+{
+    fclose(f);
+}
+#endif
+
+static int header_valid(const struct LevelHeader *header)
+{
+    if (memcmp(header->magic, LEVEL_MAGIC, 4) != 0 || header->version != LEVEL_VERSION)
+        return 0;
+    if (header->header_size < sizeof(struct LevelHeader))
+        return 0;
+    if (header->width == 0 || header->height == 0 || header->width > LEVEL_MAX_SIDE || header->height > LEVEL_MAX_SIDE)
+        return 0;
+    return header->cell_count == (unsigned int)header->width * header->height;
+}
+
+int level_load(const char *path, struct TileGrid *grid)
+{
+    LevelFile f = file_open(path);
+    if (!LEVEL_FILE_OK(f))
+        return -1;
+
+    struct LevelHeader header;
+    if (file_read(f, &header, sizeof(header)) != sizeof(header) || !header_valid(&header))
+        goto fail;
+
+    if (header.header_size != sizeof(header) && file_seek(f, header.header_size) < 0)
+        goto fail;
+
+    if (tilegrid_create(grid, header.width, header.height) < 0)
+        goto fail;
+
+    // the file stores the cells in grid order, one read puts the level in place
+    if (file_read(f, grid->cells, header.cell_count) != (int)header.cell_count)
+    {
+        tilegrid_destroy(grid);
+        goto fail;
+    }
+
+    file_close(f);
+    tilegrid_rebuild_masks(grid);
+    return 0;
+
+fail:
+    file_close(f);
+    return -1;
+}
+
+int level_rle_decode(unsigned char *dest, unsigned int dest_size, const unsigned char *src, unsigned int src_size)
+{
+    unsigned char *out = dest;
+    unsigned char *end = dest + dest_size;
+
+    for (unsigned int i = 0; i < src_size; i++)
+    {
+        // read the token before writing, the run may overwrite it when decoding in place
+        unsigned char token = src[i];
+        unsigned int run = (token >> 4) + 1;
+        unsigned char tile = token & 0x0F;
+
+        if (run > (unsigned int)(end - out))
+            return -1;
+
+        memset(out, tile, run);
+        out += run;
+    }
+
+    return out == end ? (int)dest_size : -1;
+}
+
+int levelpack_open(const char *path, struct LevelPack *pack)
+{
+    memset(pack, 0, sizeof(*pack));
+
+    pack->file = file_open(path);
+    if (!LEVEL_FILE_OK(pack->file))
+        return -1;
+
+    struct PackHeader header;
+    if (file_read(pack->file, &header, sizeof(header)) != sizeof(header))
+        goto fail;
+    if (memcmp(header.magic, PACK_MAGIC, 4) != 0 || header.version != PACK_VERSION || header.level_count == 0)
+        goto fail;
+
+    // the index is small (12 bytes per level) and stays in RAM, the levels do not
+    unsigned int index_size = header.level_count * sizeof(struct PackEntry);
+    pack->index = (struct PackEntry *)malloc(index_size);
+    if (!pack->index)
+        goto fail;
+
+    if (file_seek(pack->file, header.index_offset) < 0 || file_read(pack->file, pack->index, index_size) != (int)index_size)
+        goto fail;
+
+    pack->level_count = header.level_count;
+    return 0;
+
+fail:
+    levelpack_close(pack);
+    return -1;
+}
+
+void levelpack_close(struct LevelPack *pack)
+{
+    if (LEVEL_FILE_OK(pack->file))
+        file_close(pack->file);
+    free(pack->index);
+    memset(pack, 0, sizeof(*pack));
+    pack->file = LEVEL_NO_FILE;
+}
+
+int levelpack_load(struct LevelPack *pack, unsigned int number, struct TileGrid *grid)
+{
+    if (number >= pack->level_count)
+        return -1;
+
+    const struct PackEntry *entry = &pack->index[number];
+    unsigned int cell_count = (unsigned int)entry->width * entry->height;
+
+    if (entry->width == 0 || entry->height == 0 || entry->width > LEVEL_MAX_SIDE || entry->height > LEVEL_MAX_SIDE)
+        return -1;
+    if (entry->packed_size == 0 || entry->packed_size > cell_count)
+        return -1;
+
+    if (tilegrid_create(grid, entry->width, entry->height) < 0)
+        return -1;
+
+    // the encoded cells are read into the end of the grid and decoded forward over themselves
+    unsigned char *packed = grid->cells + cell_count - entry->packed_size;
+
+    if (file_seek(pack->file, entry->offset) < 0 || file_read(pack->file, packed, entry->packed_size) != (int)entry->packed_size)
+    {
+        tilegrid_destroy(grid);
+        return -1;
+    }
+
+    unsigned int start = time_us();
+    int decoded = level_rle_decode(grid->cells, cell_count, packed, entry->packed_size);
+    pack->decode_us = time_us() - start;
+    pack->packed_size = entry->packed_size;
+    pack->cell_count = cell_count;
+
+    if (decoded < 0)
+    {
+        tilegrid_destroy(grid);
+        return -1;
+    }
+
+    tilegrid_rebuild_masks(grid);
+    return 0;
+}
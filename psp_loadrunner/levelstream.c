@@ -0,0 +1,144 @@
+#include "headers/levelstream.h"
+#include "headers/quads.h"
+
+#include <string.h>
+
+// lower priority than the main thread (0x20) so loading never delays a frame
+#define LOADER_PRIORITY (0x30)
+#define LOADER_STACK_SIZE (0x4000)
+
+static int loader_thread(SceSize args, void *argp)
+{
+    struct LevelStream *stream = *(struct LevelStream **)argp;
+
+    while (1)
+    {
+        sceKernelWaitSema(stream->request_sema, 1, NULL);
+        if (stream->quit)
+            break;
+
+        unsigned int start = sceKernelGetSystemTimeLow();
+
+        // next was freed by levelstream_swap. the map is built with BUFFER_RAM meshes only (see
+        // tilemap_create_from_grid), the EDRAM blocks of gpubuffer.c belong to the main thread
+        struct TileGrid grid;
+        stream->result = levelpack_load(&stream->pack, stream->number, &grid);
+        if (stream->result == 0)
+            stream->result = tilemap_create_from_grid(stream->next, &grid);
+
+        stream->done_time = sceKernelGetSystemTimeLow();
+        stream->load_us = stream->done_time - start;
+        stream->decode_us = stream->pack.decode_us;
+        sceKernelSignalSema(stream->done_sema, 1);
+    }
+
+    sceKernelExitThread(0);
+    return 0;
+}
+
+int levelstream_start(struct LevelStream *stream, const char *pack_path)
+{
+    memset(stream, 0, sizeof(*stream));
+    stream->current = &stream->maps[0];
+    stream->next = &stream->maps[1];
+    stream->thread = stream->request_sema = stream->done_sema = -1;
+
+    if (levelpack_open(pack_path, &stream->pack) < 0)
+        return -1;
+
+    // the shared quad indices take EDRAM the first time, that must not happen on the loader thread
+    quads_init();
+
+    stream->request_sema = sceKernelCreateSema("level_request", 0, 0, 1, NULL);
+    stream->done_sema = sceKernelCreateSema("level_done", 0, 0, 1, NULL);
+    stream->thread = sceKernelCreateThread("level_loader", loader_thread, LOADER_PRIORITY, LOADER_STACK_SIZE, THREAD_ATTR_USER, NULL);
+
+    if (stream->request_sema < 0 || stream->done_sema < 0 || stream->thread < 0)
+    {
+        levelstream_stop(stream);
+        return -1;
+    }
+
+    // the thread gets a copy of the arguments, so pass the address of the stream
+    sceKernelStartThread(stream->thread, sizeof(stream), &stream);
+    return 0;
+}
+
+void levelstream_stop(struct LevelStream *stream)
+{
+    if (stream->thread >= 0 && stream->request_sema >= 0)
+    {
+        // let a pending load finish before tearing the maps down
+        if (stream->pending)
+            sceKernelWaitSema(stream->done_sema, 1, NULL);
+
+        stream->quit = 1;
+        sceKernelSignalSema(stream->request_sema, 1);
+        sceKernelWaitThreadEnd(stream->thread, NULL);
+    }
+
+    if (stream->thread >= 0)
+        sceKernelDeleteThread(stream->thread);
+    if (stream->request_sema >= 0)
+        sceKernelDeleteSema(stream->request_sema);
+    if (stream->done_sema >= 0)
+        sceKernelDeleteSema(stream->done_sema);
+
+    tilemap_destroy(&stream->maps[0]);
+    tilemap_destroy(&stream->maps[1]);
+    levelpack_close(&stream->pack);
+
+    stream->thread = stream->request_sema = stream->done_sema = -1;
+    stream->pending = 0;
+}
+
+int levelstream_prefetch(struct LevelStream *stream, unsigned int number)
+{
+    if (stream->pending || number >= stream->pack.level_count)
+        return -1;
+
+    stream->number = number;
+    stream->pending = 1;
+    stream->request_time = sceKernelGetSystemTimeLow();
+    sceKernelSignalSema(stream->request_sema, 1);
+    return 0;
+}
+
+int levelstream_ready(struct LevelStream *stream)
+{
+    if (!stream->pending)
+        return 0;
+
+    // poll takes the signal, give it back so levelstream_swap still sees it
+    if (sceKernelPollSema(stream->done_sema, 1) < 0)
+        return 0;
+    sceKernelSignalSema(stream->done_sema, 1);
+    return 1;
+}
+
+int levelstream_swap(struct LevelStream *stream)
+{
+    if (!stream->pending)
+        return -1;
+
+    unsigned int start = sceKernelGetSystemTimeLow();
+    sceKernelWaitSema(stream->done_sema, 1, NULL);
+    unsigned int now = sceKernelGetSystemTimeLow();
+
+    stream->pending = 0;
+    stream->stall_us = now - start;
+    // not until the swap: the prefetch is requested right after the previous swap, that would count
+    // the time the previous level was played
+    stream->ready_us = stream->done_time - stream->request_time;
+
+    if (stream->result < 0)
+        return -1;
+
+    struct Tilemap *previous = stream->current;
+    stream->current = stream->next;
+    stream->next = previous;
+
+    // the old level goes back to the allocators on the main thread, the GE finished with it at the last sync
+    tilemap_destroy(stream->next);
+    return 0;
+}
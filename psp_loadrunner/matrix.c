@@ -0,0 +1,192 @@
+#include "headers/matrix.h"
+
+#include <pspgu.h>
+#include <string.h>
+
+static ScePspFMatrix4 __attribute__((aligned(16))) stacks[MATRIX_MODE_COUNT][MATRIX_STACK_DEPTH];
+static ScePspFMatrix4 __attribute__((aligned(16))) uploaded[MATRIX_MODE_COUNT]; // what the GE holds
+static int tops[MATRIX_MODE_COUNT];
+static unsigned int dirty = 0;    // bit per mode, its top changed since the last upload
+static unsigned int on_ge = 0;    // bit per mode, uploaded[mode] is valid
+static int current = GU_MODEL;
+
+struct MatrixStats matrix_stats;
+
+static const ScePspFMatrix4 identity = {
+    {1.0f, 0.0f, 0.0f, 0.0f},
+    {0.0f, 1.0f, 0.0f, 0.0f},
+    {0.0f, 0.0f, 1.0f, 0.0f},
+    {0.0f, 0.0f, 0.0f, 1.0f},
+};
+
+static inline ScePspFMatrix4 *top_matrix(void)
+{
+    return &stacks[current][tops[current]];
+}
+
+// the matrices are column major (x, y, z and w are columns), C000 .. C030 hold the top matrix
+
+// m = m * translation: w += x * column x + y * column y + z * column z
+static inline void vfpu_translate(ScePspFMatrix4 *m, const ScePspFVector4 *t)
+{
+    __asm__ volatile(
+        "lv.q    C000,  0(%0)\n"
+        "lv.q    C010, 16(%0)\n"
+        "lv.q    C020, 32(%0)\n"
+        "lv.q    C030, 48(%0)\n"
+        "lv.q    C100,  0(%1)\n"
+        "vscl.q  C200, C000, S100\n"
+        "vadd.q  C030, C030, C200\n"
+        "vscl.q  C200, C010, S101\n"
+        "vadd.q  C030, C030, C200\n"
+        "vscl.q  C200, C020, S102\n"
+        "vadd.q  C030, C030, C200\n"
+        "sv.q    C030, 48(%0)\n"
+        :
+        : "r"(m), "r"(t)
+        : "memory");
+}
+
+// m = m * scale: every column times its factor
+static inline void vfpu_scale(ScePspFMatrix4 *m, const ScePspFVector4 *s)
+{
+    __asm__ volatile(
+        "lv.q    C000,  0(%0)\n"
+        "lv.q    C010, 16(%0)\n"
+        "lv.q    C020, 32(%0)\n"
+        "lv.q    C100,  0(%1)\n"
+        "vscl.q  C000, C000, S100\n"
+        "vscl.q  C010, C010, S101\n"
+        "vscl.q  C020, C020, S102\n"
+        "sv.q    C000,  0(%0)\n"
+        "sv.q    C010, 16(%0)\n"
+        "sv.q    C020, 32(%0)\n"
+        :
+        : "r"(m), "r"(s)
+        : "memory");
+}
+
+// m = m * b
+static inline void vfpu_multiply(ScePspFMatrix4 *m, const ScePspFMatrix4 *b)
+{
+    __asm__ volatile(
+        "lv.q    C000,  0(%0)\n"
+        "lv.q    C010, 16(%0)\n"
+        "lv.q    C020, 32(%0)\n"
+        "lv.q    C030, 48(%0)\n"
+        "lv.q    C100,  0(%1)\n"
+        "lv.q    C110, 16(%1)\n"
+        "lv.q    C120, 32(%1)\n"
+        "lv.q    C130, 48(%1)\n"
+        "vmmul.q M200, M000, M100\n"
+        "sv.q    C200,  0(%0)\n"
+        "sv.q    C210, 16(%0)\n"
+        "sv.q    C220, 32(%0)\n"
+        "sv.q    C230, 48(%0)\n"
+        :
+        : "r"(m), "r"(b)
+        : "memory");
+}
+
+void matrix_init(void)
+{
+    for (int mode = 0; mode < MATRIX_MODE_COUNT; mode++)
+    {
+        tops[mode] = 0;
+        stacks[mode][0] = identity;
+    }
+    dirty = (1 << MATRIX_MODE_COUNT) - 1;
+    on_ge = 0;
+    current = GU_MODEL;
+}
+
+void matrix_mode(int mode)
+{
+    current = mode;
+}
+
+void matrix_push(void)
+{
+    if (tops[current] + 1 >= MATRIX_STACK_DEPTH)
+        return;
+
+    // the copy is equal to the old top, nothing to upload
+    stacks[current][tops[current] + 1] = stacks[current][tops[current]];
+    tops[current]++;
+}
+
+void matrix_pop(void)
+{
+    if (tops[current] == 0)
+        return;
+
+    tops[current]--;
+    dirty |= 1 << current;
+}
+
+void matrix_identity(void)
+{
+    *top_matrix() = identity;
+    dirty |= 1 << current;
+}
+
+void matrix_load(const ScePspFMatrix4 *m)
+{
+    *top_matrix() = *m;
+    dirty |= 1 << current;
+}
+
+void matrix_multiply(const ScePspFMatrix4 *m)
+{
+    vfpu_multiply(top_matrix(), m);
+    dirty |= 1 << current;
+}
+
+void matrix_translate(float x, float y, float z)
+{
+    ScePspFVector4 __attribute__((aligned(16))) t = {x, y, z, 0.0f};
+    vfpu_translate(top_matrix(), &t);
+    dirty |= 1 << current;
+}
+
+void matrix_scale(float x, float y, float z)
+{
+    ScePspFVector4 __attribute__((aligned(16))) s = {x, y, z, 1.0f};
+    vfpu_scale(top_matrix(), &s);
+    dirty |= 1 << current;
+}
+
+void matrix_ortho(float left, float right, float bottom, float top, float near, float far)
+{
+    ScePspFMatrix4 __attribute__((aligned(16))) m = {
+        {2.0f / (right - left), 0.0f, 0.0f, 0.0f},
+        {0.0f, 2.0f / (top - bottom), 0.0f, 0.0f},
+        {0.0f, 0.0f, -2.0f / (far - near), 0.0f},
+        {-(right + left) / (right - left), -(top + bottom) / (top - bottom), -(far + near) / (far - near), 1.0f},
+    };
+    matrix_multiply(&m);
+}
+
+void matrix_upload(void)
+{
+    for (int mode = 0; dirty; mode++)
+    {
+        unsigned int bit = 1 << mode;
+        if (!(dirty & bit))
+            continue;
+        dirty &= ~bit;
+
+        // a transform set again to the same values every frame ends here
+        const ScePspFMatrix4 *m = &stacks[mode][tops[mode]];
+        if ((on_ge & bit) && memcmp(m, &uploaded[mode], sizeof(*m)) == 0)
+        {
+            matrix_stats.skipped++;
+            continue;
+        }
+
+        sceGuSetMatrix(mode, m);
+        uploaded[mode] = *m;
+        on_ge |= bit;
+        matrix_stats.uploads++;
+    }
+}
@@ -0,0 +1,347 @@
+#include "headers/mesh.h"
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __PSP__
+#include "headers/matrix.h"
+#include "headers/strip.h"
+
+#include <pspgu.h>
+#include <pspkernel.h>
+
+_Static_assert(MESH_VERTEX_TYPE(MESH_16BIT, MESH_COLOR_8888, MESH_8BIT, MESH_FLOAT) ==
+                   (GU_TEXTURE_16BIT | GU_COLOR_8888 | GU_NORMAL_8BIT | GU_VERTEX_32BITF),
+               "MESH_VERTEX_TYPE does not match the GU vertex type");
+_Static_assert(MESH_VERTEX_TYPE(MESH_FLOAT, MESH_COLOR_4444, MESH_16BIT, MESH_8BIT) ==
+                   (GU_TEXTURE_32BITF | GU_COLOR_4444 | GU_NORMAL_16BIT | GU_VERTEX_8BIT),
+               "MESH_VERTEX_TYPE does not match the GU vertex type");
+
+#define MESH_FILE_OK(f) ((f) >= 0)
+
+static unsigned int time_us()
+{
+    return sceKernelGetSystemTimeLow();
+}
+
+static MeshFile file_open(const char *path)
+{
+    return sceIoOpen(path, PSP_O_RDONLY, 0777);
+}
+
+static int file_size(MeshFile f)
+{
+    int size = sceIoLseek32(f, 0, PSP_SEEK_END);
+    return sceIoLseek32(f, 0, PSP_SEEK_SET) == 0 ? size : -1;
+}
+
+static int file_read(MeshFile f, void *dest, unsigned int size)
+{
+    return sceIoRead(f, dest, size);
+}
+
+static void file_close(MeshFile f)
+{
+    sceIoClose(f);
+}
+#else
+#include <time.h>
+
+#define MESH_FILE_OK(f) ((f) != NULL)
+
+static unsigned int time_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned int)(ts.tv_sec * 1000000ull + ts.tv_nsec / 1000);
+}
+
+static MeshFile file_open(const char *path)
+{
+    return fopen(path, "rb");
+}
+
+static int file_size(MeshFile f)
+{
+    if (fseek(f, 0, SEEK_END) != 0)
+        return -1;
+    long size = ftell(f);
+    return fseek(f, 0, SEEK_SET) == 0 ? (int)size : -1;
+}
+
+static int file_read(MeshFile f, void *dest, unsigned int size)
+{
+    return (int)fread(dest, 1, size, f);
+}
+
+static void file_close(MeshFile f)
+{
+    fclose(f);
+}
+#endif
+
+// element sizes of the texture, normal and position fields, index is the MeshComponent
+static const unsigned char component_bytes[4] = {0, 1, 2, 4};
+
+static unsigned int align(unsigned int offset, unsigned int to)
+{
+    return to ? (offset + to - 1) / to * to : offset;
+}
+
+unsigned int mesh_vertex_size(unsigned int vertex_type)
+{
+    unsigned int texture = component_bytes[vertex_type & 3];
+    unsigned int color_type = (vertex_type >> 2) & 7;
+    unsigned int color = color_type == MESH_COLOR_8888 ? 4 : (color_type >= MESH_COLOR_5650 ? 2 : 0);
+    unsigned int normal = component_bytes[(vertex_type >> 5) & 3];
+    unsigned int position = component_bytes[(vertex_type >> 7) & 3];
+
+    // same order as the GE reads them: texture, color, normal, position
+    unsigned int size = align(0, texture) + 2 * texture;
+    size = align(size, color) + color;
+    size = align(size, normal) + 3 * normal;
+    size = align(size, position) + 3 * position;
+
+    unsigned int largest = texture > color ? texture : color;
+    largest = normal > largest ? normal : largest;
+    largest = position > largest ? position : largest;
+    return align(size, largest);
+}
+
+// available is what the block holds from the header on
+static int header_valid(const struct MeshHeader *header, unsigned int available)
+{
+    if (memcmp(header->magic, MESH_MAGIC, 4) != 0 || header->version != MESH_VERSION)
+        return 0;
+    if (header->header_size < sizeof(struct MeshHeader) || header->prim > MESH_STRIP || header->lod_error < 0.0f)
+        return 0;
+    // the level has to fit and the next one has to start aligned
+    unsigned int size = header->file_size;
+    if (size < header->header_size || size > available || (size & 15))
+        return 0;
+    // no position or a color field the GE does not know
+    if (((header->vertex_type >> 7) & 3) == MESH_NONE || (header->vertex_type & ~0x1FFu) != 0)
+        return 0;
+    unsigned int color = (header->vertex_type >> 2) & 7;
+    if (color != MESH_COLOR_NONE && color < MESH_COLOR_5650)
+        return 0;
+    if (header->vertex_size != mesh_vertex_size(header->vertex_type) || header->vertex_count > 65536)
+        return 0;
+    // strips are always indexed, strip_draw needs the indices
+    if (header->prim == MESH_STRIP && header->index_count == 0)
+        return 0;
+
+    // the blocks aligned and inside the level
+    if ((header->vertex_offset | header->index_offset | header->bbox_offset) & 15)
+        return 0;
+    if (header->vertex_offset < header->header_size || header->vertex_offset > size ||
+        header->vertex_count > (size - header->vertex_offset) / header->vertex_size)
+        return 0;
+    if (header->index_offset > size || header->index_count > (size - header->index_offset) / sizeof(unsigned short))
+        return 0;
+    return header->bbox_offset <= size && 8 * mesh_vertex_size(header->vertex_type & MESH_POSITION_BITS) <= size - header->bbox_offset;
+}
+
+// the whole file in one read into a 16 byte aligned block, the vertices and indices are used where they land
+static unsigned char *read_block(const char *path, unsigned int *size, unsigned int *load_us)
+{
+    unsigned int start = time_us();
+    MeshFile f = file_open(path);
+    if (!MESH_FILE_OK(f))
+        return NULL;
+
+    unsigned char *block = NULL;
+    int length = file_size(f);
+    if (length >= (int)sizeof(struct MeshHeader) && length <= MESH_MAX_SIZE)
+        block = (unsigned char *)memalign(16, length);
+    if (block != NULL && file_read(f, block, length) != length)
+    {
+        free(block);
+        block = NULL;
+    }
+    file_close(f);
+
+#ifdef __PSP__
+    // the GE reads the vertices and indices straight from the block
+    if (block != NULL)
+        sceKernelDcacheWritebackRange(block, length);
+#endif
+    *size = length;
+    *load_us = time_us() - start;
+    return block;
+}
+
+// points mesh at the level whose header is at offset in the block, returns the size of the level or 0
+static unsigned int attach(struct Mesh *mesh, unsigned char *block, unsigned int offset, unsigned int size)
+{
+    const struct MeshHeader *header = (const struct MeshHeader *)(block + offset);
+    if (size - offset < sizeof(struct MeshHeader) || !header_valid(header, size - offset))
+        return 0;
+
+    mesh->header = header;
+    mesh->vertices = (const unsigned char *)header + header->vertex_offset;
+    mesh->indices = (const unsigned short *)((const unsigned char *)header + header->index_offset);
+    mesh->bbox = (const unsigned char *)header + header->bbox_offset;
+    mesh->size = header->file_size;
+#ifdef __PSP__
+    mesh->vertex_flags = header->vertex_type | (header->index_count ? GU_INDEX_16BIT : 0) | GU_TRANSFORM_3D;
+    mesh->bbox_flags = (header->vertex_type & MESH_POSITION_BITS) | GU_TRANSFORM_3D;
+#endif
+    return header->file_size;
+}
+
+int mesh_load(const char *path, struct Mesh *mesh)
+{
+    memset(mesh, 0, sizeof(*mesh));
+
+    unsigned int size, load_us;
+    unsigned char *block = read_block(path, &size, &load_us);
+    if (block == NULL)
+        return -1;
+
+    if (attach(mesh, block, 0, size) == 0)
+    {
+        free(block);
+        memset(mesh, 0, sizeof(*mesh));
+        return -1;
+    }
+
+    mesh->data = block;
+    mesh->size = size;
+    mesh->load_us = load_us;
+    return 0;
+}
+
+void mesh_destroy(struct Mesh *mesh)
+{
+    free(mesh->data);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+int mesh_lod_load(const char *path, struct MeshLod *lod)
+{
+    memset(lod, 0, sizeof(*lod));
+
+    unsigned int size, load_us;
+    unsigned char *block = read_block(path, &size, &load_us);
+    if (block == NULL)
+        return -1;
+
+    // the levels follow each other to the end of the file
+    for (unsigned int offset = 0; offset < size; lod->count++)
+    {
+        unsigned int level_size = lod->count < MESH_MAX_LODS ? attach(&lod->levels[lod->count], block, offset, size) : 0;
+        if (level_size == 0)
+        {
+            free(block);
+            memset(lod, 0, sizeof(*lod));
+            return -1;
+        }
+        lod->levels[lod->count].load_us = load_us;
+        offset += level_size;
+    }
+
+    lod->levels[0].data = block;
+    lod->max_error_pixels = 1.0f;
+    return 0;
+}
+
+void mesh_lod_destroy(struct MeshLod *lod)
+{
+    free(lod->levels[0].data);
+    memset(lod, 0, sizeof(*lod));
+}
+
+unsigned int mesh_lod_select(struct MeshLod *lod, float pixels_per_unit)
+{
+    unsigned int level = lod->current < lod->count ? lod->current : 0;
+    float limit = lod->max_error_pixels;
+
+    // the level grew too big on screen: back to finer levels until one is good enough, level 0 always is
+    while (level > 0 && lod->levels[level].header->lod_error * pixels_per_unit > limit)
+        level--;
+
+    // coarser levels only once they are well under the limit
+    while (level + 1 < lod->count && lod->levels[level + 1].header->lod_error * pixels_per_unit <= limit * (1.0f - MESH_LOD_HYSTERESIS))
+        level++;
+
+    lod->current = level;
+    return level;
+}
+
+#ifdef __PSP__
+// a draw takes at most 65535 vertices, a list is cut on a whole triangle
+#define LIST_DRAW_MAX (65535)
+
+struct MeshCullStats mesh_cull_stats;
+
+// the pspsdk swapped the two arguments of sceGuSignal between versions, the signal number is the
+// value of the behavior so the call means the same either way
+#define DRAWN_SIGNAL (GU_BEHAVIOR_CONTINUE)
+
+#if MESH_COUNT_DRAWN
+static void drawn_signal(int signal)
+{
+    if (signal == DRAWN_SIGNAL)
+        mesh_cull_stats.drawn++;
+}
+#endif
+
+void mesh_cull_init(void)
+{
+#if MESH_COUNT_DRAWN
+    sceGuSetCallback(GU_CALLBACK_SIGNAL, drawn_signal);
+#endif
+}
+
+void mesh_draw(const struct Mesh *mesh)
+{
+    const struct MeshHeader *header = mesh->header;
+
+    if (header->vertex_type & 3)
+    {
+        sceGuTexScale(header->uv_scale[0], header->uv_scale[1]);
+        sceGuTexOffset(header->uv_offset[0], header->uv_offset[1]);
+    }
+
+    matrix_mode(GU_MODEL);
+    matrix_push();
+    matrix_translate(header->position_offset[0], header->position_offset[1], header->position_offset[2]);
+    matrix_scale(header->position_scale[0], header->position_scale[1], header->position_scale[2]);
+    // everything that changes state the CPU keeps track of goes before the box, the GE may skip what is inside.
+    // matrix_upload in strip_draw finds the matrices clean
+    matrix_upload();
+    sceGuBeginObject(mesh->bbox_flags, 8, NULL, mesh->bbox);
+    mesh_cull_stats.submitted++;
+
+    unsigned int count = header->index_count ? header->index_count : header->vertex_count;
+    if (header->prim == MESH_STRIP)
+    {
+        strip_draw(mesh->vertex_flags, count, mesh->indices, mesh->vertices);
+    }
+    else
+    {
+        for (unsigned int first = 0; first < count; first += LIST_DRAW_MAX)
+        {
+            unsigned int part = count - first < LIST_DRAW_MAX ? count - first : LIST_DRAW_MAX;
+            if (header->index_count)
+                sceGuDrawArray(GU_TRIANGLES, mesh->vertex_flags, part, mesh->indices + first, mesh->vertices);
+            else
+                sceGuDrawArray(GU_TRIANGLES, mesh->vertex_flags, part, NULL,
+                               (const unsigned char *)mesh->vertices + first * header->vertex_size);
+        }
+    }
+
+#if MESH_COUNT_DRAWN
+    sceGuSignal(DRAWN_SIGNAL, GU_BEHAVIOR_CONTINUE);
+#endif
+    sceGuEndObject();
+    matrix_pop();
+}
+
+void mesh_lod_draw(const struct MeshLod *lod)
+{
+    mesh_draw(&lod->levels[lod->current]);
+}
+#endif
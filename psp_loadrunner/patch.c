@@ -0,0 +1,241 @@
+#include "headers/patch.h"
+
+#include <math.h>
+
+#ifdef __PSP__
+#include "headers/matrix.h"
+
+#include <pspgu.h>
+
+_Static_assert(PATCH_FILL_FILL == GU_FILL_FILL && PATCH_OPEN_FILL == GU_OPEN_FILL && PATCH_FILL_OPEN == GU_FILL_OPEN &&
+                   PATCH_OPEN_OPEN == GU_OPEN_OPEN,
+               "enum PatchEdge does not match the GU spline edges");
+#endif
+
+unsigned int patch_spans(const struct Patch *patch, int v_side)
+{
+    unsigned int count = v_side ? patch->vcount : patch->ucount;
+    if (count < 4)
+        return 0;
+    return patch->type == PATCH_BEZIER ? (count - 1) / 3 : count - 3;
+}
+
+unsigned int patch_triangles(const struct Patch *patch)
+{
+    return 2 * patch_spans(patch, 0) * patch->divide_u * patch_spans(patch, 1) * patch->divide_v;
+}
+
+// weights of the 4 control points of a cubic bezier span at t
+static void bezier_basis(float t, float *w)
+{
+    float it = 1.0f - t;
+    w[0] = it * it * it;
+    w[1] = 3.0f * t * it * it;
+    w[2] = 3.0f * t * t * it;
+    w[3] = t * t * t;
+}
+
+// weights of the 4 control points of span k of a cubic B-spline at x (in spans). the knots are uniform,
+// a filled end repeats its first or last knot 4 times so the curve reaches the end point
+static void spline_basis(unsigned int count, int edge, unsigned int k, float x, float *w)
+{
+    unsigned int spans = count - 3;
+    int open_start = edge == PATCH_OPEN_FILL || edge == PATCH_OPEN_OPEN;
+    int open_end = edge == PATCH_FILL_OPEN || edge == PATCH_OPEN_OPEN;
+
+    // knot i + 3 is at i, only the knots around span k are used
+    float knots[PATCH_MAX_SIDE + 4];
+    for (unsigned int i = 0; i < count + 4; i++)
+    {
+        float knot = (float)i - 3.0f;
+        if (knot < 0.0f && !open_start)
+            knot = 0.0f;
+        if (knot > spans && !open_end)
+            knot = spans;
+        knots[i] = knot;
+    }
+
+    // Cox de Boor, the 4 non zero basis functions of knot span k + 3
+    unsigned int span = k + 3;
+    float left[4], right[4];
+    w[0] = 1.0f;
+    for (int j = 1; j <= 3; j++)
+    {
+        left[j] = x - knots[span + 1 - j];
+        right[j] = knots[span + j] - x;
+        float saved = 0.0f;
+        for (int r = 0; r < j; r++)
+        {
+            float temp = w[r] / (right[r + 1] + left[j - r]);
+            w[r] = saved + right[r + 1] * temp;
+            saved = left[j - r] * temp;
+        }
+        w[j] = saved;
+    }
+}
+
+// first control point and weights along one side at s (0 .. 1)
+static unsigned int side_basis(const struct Patch *patch, int v_side, float s, float *w)
+{
+    unsigned int count = v_side ? patch->vcount : patch->ucount;
+    unsigned int spans = patch_spans(patch, v_side);
+
+    float x = s * spans;
+    unsigned int k = x <= 0.0f ? 0 : (unsigned int)x;
+    if (k >= spans)
+        k = spans - 1;
+
+    if (patch->type == PATCH_BEZIER)
+    {
+        bezier_basis(x - k, w);
+        return k * 3;
+    }
+
+    spline_basis(count, v_side ? patch->vedge : patch->uedge, k, x, w);
+    return k;
+}
+
+void patch_evaluate(const struct Patch *patch, float s, float t, struct PatchVertex *out)
+{
+    float wu[4], wv[4];
+    unsigned int iu = side_basis(patch, 0, s, wu);
+    unsigned int iv = side_basis(patch, 1, t, wv);
+
+    float x = 0.0f, y = 0.0f, z = 0.0f, u = 0.0f, v = 0.0f;
+    float channels[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    for (int j = 0; j < 4; j++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            const struct PatchVertex *p = patch->control + (iv + j) * patch->ucount + iu + i;
+            float w = wu[i] * wv[j];
+            x += p->x * w;
+            y += p->y * w;
+            z += p->z * w;
+            u += p->u * w;
+            v += p->v * w;
+            for (int c = 0; c < 4; c++)
+                channels[c] += ((p->color >> (c * 8)) & 0xFF) * w;
+        }
+    }
+
+    unsigned int color = 0;
+    for (int c = 0; c < 4; c++)
+    {
+        float channel = channels[c] + 0.5f;
+        color |= (channel < 0.0f ? 0 : channel > 255.0f ? 255 : (unsigned int)channel) << (c * 8);
+    }
+
+    *out = (struct PatchVertex){u, v, color, x, y, z};
+}
+
+void patch_tessellate(const struct Patch *patch, struct PatchVertex *out)
+{
+    unsigned int columns = patch_spans(patch, 0) * patch->divide_u;
+    unsigned int rows = patch_spans(patch, 1) * patch->divide_v;
+
+    for (unsigned int j = 0; j <= rows; j++)
+        for (unsigned int i = 0; i <= columns; i++)
+            patch_evaluate(patch, (float)i / columns, (float)j / rows, out++);
+}
+
+// the 4 bezier points of a circle arc of center cx, cy from angle a0 to a1 (radians, up to a quarter turn)
+static void arc_points(float *px, float *py, float cx, float cy, float radius, float a0, float a1)
+{
+    // the inner points sit along the tangents, 4/3 tan(angle / 4) of the radius away
+    float k = 4.0f / 3.0f * tanf((a1 - a0) / 4.0f) * radius;
+
+    px[0] = cx + radius * cosf(a0);
+    py[0] = cy + radius * sinf(a0);
+    px[3] = cx + radius * cosf(a1);
+    py[3] = cy + radius * sinf(a1);
+    px[1] = px[0] - k * sinf(a0);
+    py[1] = py[0] + k * cosf(a0);
+    px[2] = px[3] + k * sinf(a1);
+    py[2] = py[3] - k * cosf(a1);
+}
+
+static void line_points(float *px, float *py, float x0, float y0, float x1, float y1)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        px[i] = x0 + (x1 - x0) * i / 3.0f;
+        py[i] = y0 + (y1 - y0) * i / 3.0f;
+    }
+}
+
+// one side of the outline: half a corner arc, a straight run, half of the next corner arc
+static void outline_side(float *px, float *py, float c0x, float c0y, float a0, float c1x, float c1y, float a1,
+                         float radius, float quarter)
+{
+    arc_points(px, py, c0x, c0y, radius, a0, a0 + quarter);
+    line_points(px + 3, py + 3, px[3], py[3], c1x + radius * cosf(a1 - quarter), c1y + radius * sinf(a1 - quarter));
+    arc_points(px + 6, py + 6, c1x, c1y, radius, a1 - quarter, a1);
+}
+
+void patch_rounded_panel(struct Patch *patch, struct PatchVertex *control, float x, float y, float w, float h,
+                         float radius, unsigned int color)
+{
+    const float eighth = 3.14159265f / 4.0f;
+    float left = x + radius, right = x + w - radius;
+    float bottom = y + radius, top = y + h - radius;
+
+    // the grid corners are the middles of the rounded corners, each side runs corner middle to corner middle.
+    // the arcs of the bottom and right sides turn counterclockwise, those of the top and left clockwise
+    float bx[PATCH_PANEL_SIDE], by[PATCH_PANEL_SIDE], tx[PATCH_PANEL_SIDE], ty[PATCH_PANEL_SIDE];
+    float lx[PATCH_PANEL_SIDE], ly[PATCH_PANEL_SIDE], rx[PATCH_PANEL_SIDE], ry[PATCH_PANEL_SIDE];
+    outline_side(bx, by, left, bottom, 5 * eighth, right, bottom, 7 * eighth, radius, eighth);
+    outline_side(tx, ty, left, top, 3 * eighth, right, top, 1 * eighth, radius, -eighth);
+    outline_side(lx, ly, left, bottom, 5 * eighth, left, top, 3 * eighth, radius, -eighth);
+    outline_side(rx, ry, right, bottom, 7 * eighth, right, top, 9 * eighth, radius, eighth);
+
+    // the inside blends the 4 sides (a Coons patch over the control grid), flat like the outline
+    for (int j = 0; j < PATCH_PANEL_SIDE; j++)
+    {
+        float b = (float)j / (PATCH_PANEL_SIDE - 1);
+        for (int i = 0; i < PATCH_PANEL_SIDE; i++)
+        {
+            float a = (float)i / (PATCH_PANEL_SIDE - 1);
+            int last = PATCH_PANEL_SIDE - 1;
+
+            float px = (1 - b) * bx[i] + b * tx[i] + (1 - a) * lx[j] + a * rx[j] -
+                       ((1 - a) * (1 - b) * bx[0] + a * (1 - b) * bx[last] + (1 - a) * b * tx[0] + a * b * tx[last]);
+            float py = (1 - b) * by[i] + b * ty[i] + (1 - a) * ly[j] + a * ry[j] -
+                       ((1 - a) * (1 - b) * by[0] + a * (1 - b) * by[last] + (1 - a) * b * ty[0] + a * b * ty[last]);
+
+            control[j * PATCH_PANEL_SIDE + i] = (struct PatchVertex){(px - x) / w, 1.0f - (py - y) / h, color, px, py, 0.0f};
+        }
+    }
+
+    *patch = (struct Patch){control, PATCH_PANEL_SIDE, PATCH_PANEL_SIDE, PATCH_BEZIER, PATCH_FILL_FILL, PATCH_FILL_FILL, 4, 4, PATCH_SURFACE};
+}
+
+#ifdef __PSP__
+// the GE keeps its patch settings between draws, so they are only sent when a patch needs other ones
+static int current_divide_u = -1, current_divide_v = -1, current_prim = -1;
+
+static const int patch_prims[] = {GU_TRIANGLE_STRIP, GU_LINE_STRIP, GU_POINTS};
+
+void patch_draw(const struct Patch *patch)
+{
+    if (patch->divide_u != current_divide_u || patch->divide_v != current_divide_v)
+    {
+        sceGuPatchDivide(patch->divide_u, patch->divide_v);
+        current_divide_u = patch->divide_u;
+        current_divide_v = patch->divide_v;
+    }
+    if (patch->prim != current_prim)
+    {
+        sceGuPatchPrim(patch_prims[patch->prim]);
+        current_prim = patch->prim;
+    }
+
+    matrix_upload();
+    if (patch->type == PATCH_BEZIER)
+        sceGuDrawBezier(PATCH_VERTEX_FLAGS | GU_TRANSFORM_3D, patch->ucount, patch->vcount, NULL, patch->control);
+    else
+        sceGuDrawSpline(PATCH_VERTEX_FLAGS | GU_TRANSFORM_3D, patch->ucount, patch->vcount, patch->uedge, patch->vedge,
+                        NULL, patch->control);
+}
+#endif
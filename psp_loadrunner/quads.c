@@ -0,0 +1,67 @@
+#include "headers/quads.h"
+#include "headers/matrix.h"
+#include "headers/gpubuffer.h"
+
+#include <pspgu.h>
+#include <pspkernel.h>
+
+static unsigned short __attribute__((aligned(16))) quad_indices[QUAD_MAX * 6];
+static int quad_indices_ready = 0;
+
+// copy of the start of the list in EDRAM, the draws that fit take no bus bandwidth for their indices
+static struct GpuBuffer vram_indices;
+
+void quads_init(void)
+{
+    if (quad_indices_ready)
+        return;
+
+    for (unsigned int i = 0; i < QUAD_MAX; i++)
+    {
+        quad_indices[i * 6 + 0] = i * 4 + 0;
+        quad_indices[i * 6 + 1] = i * 4 + 1;
+        quad_indices[i * 6 + 2] = i * 4 + 2;
+        quad_indices[i * 6 + 3] = i * 4 + 2;
+        quad_indices[i * 6 + 4] = i * 4 + 3;
+        quad_indices[i * 6 + 5] = i * 4 + 0;
+    }
+
+    // the GE reads the indices straight from RAM
+    sceKernelDcacheWritebackRange(quad_indices, sizeof(quad_indices));
+
+    if (gpubuffer_create(&vram_indices, QUAD_VRAM_MAX * 6 * sizeof(unsigned short), BUFFER_VRAM) == 0)
+        gpubuffer_upload(&vram_indices, 0, quad_indices, vram_indices.size);
+
+    quad_indices_ready = 1;
+}
+
+void quads_draw(int vertex_flags, unsigned int vertex_size, unsigned int quads, const void *vertices)
+{
+    const unsigned char *base = (const unsigned char *)vertices;
+    unsigned int first = 0; // first quad of the next draw, relative to base
+
+    while (quads > 0)
+    {
+        unsigned int count = quads < QUAD_DRAW_MAX ? quads : QUAD_DRAW_MAX;
+        if (first + count > QUAD_MAX)
+            count = QUAD_MAX - first;
+
+        const unsigned short *indices = quad_indices;
+        if (vram_indices.data && first + count <= QUAD_VRAM_MAX)
+            indices = (const unsigned short *)vram_indices.data;
+
+        if (!(vertex_flags & GU_TRANSFORM_2D))
+            matrix_upload();
+        sceGuDrawArray(GU_TRIANGLES, vertex_flags | GU_INDEX_16BIT, count * 6, indices + first * 6, base);
+
+        quads -= count;
+        first += count;
+
+        // past the reach of 16 bit indices, the next quads start over from a new base
+        if (first == QUAD_MAX)
+        {
+            base += QUAD_MAX * 4 * vertex_size;
+            first = 0;
+        }
+    }
+}
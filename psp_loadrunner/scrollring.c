@@ -0,0 +1,289 @@
+#include "headers/scrollring.h"
+#include "headers/atlas.h"
+
+#include <pspgu.h>
+#include <pspge.h>
+
+// the screen is composited in slices, the GE texture cache does better with narrow sprites
+#define COMPOSITE_SLICE (64)
+
+// a sprite in ring texels with its texture rectangle. clears and tile sprites are drawn in through
+// mode, straight in ring texels, so everything stays integer
+struct RingRect
+{
+    short x, y, w, h;
+    short u0, v0, u1, v1;
+};
+
+static int floor_int(float value)
+{
+    int i = (int)value;
+    return value < (float)i ? i - 1 : i;
+}
+
+// ring texel column/row of a world position. y goes down in the texture, so it is flipped
+static int ring_px(float world_x)
+{
+    return floor_int(world_x * RING_PIXELS_X);
+}
+
+static int ring_py(float world_y)
+{
+    return floor_int(-world_y * RING_PIXELS_Y);
+}
+
+// splits a rectangle given in unwrapped ring texels into the pieces it covers once wrapped, returns how many
+static int wrap_rect(struct RingRect *out, int px, int py, int pw, int ph, int u0, int v0, int u1, int v1)
+{
+    if (pw <= 0 || ph <= 0)
+        return 0;
+
+    int x = px & (RING_SIZE - 1);
+    int y = py & (RING_SIZE - 1);
+
+    // at most two pieces per axis
+    int xs[2], ws[2], us[3];
+    int ys[2], hs[2], vs[3];
+    int nx = 1, ny = 1;
+
+    xs[0] = x;
+    ws[0] = pw;
+    us[0] = u0;
+    us[1] = u1;
+    if (x + pw > RING_SIZE)
+    {
+        ws[0] = RING_SIZE - x;
+        xs[1] = 0;
+        ws[1] = pw - ws[0];
+        us[1] = u0 + (u1 - u0) * ws[0] / pw;
+        us[2] = u1;
+        nx = 2;
+    }
+
+    ys[0] = y;
+    hs[0] = ph;
+    vs[0] = v0;
+    vs[1] = v1;
+    if (y + ph > RING_SIZE)
+    {
+        hs[0] = RING_SIZE - y;
+        ys[1] = 0;
+        hs[1] = ph - hs[0];
+        vs[1] = v0 + (v1 - v0) * hs[0] / ph;
+        vs[2] = v1;
+        ny = 2;
+    }
+
+    int n = 0;
+    for (int j = 0; j < ny; j++)
+    {
+        for (int i = 0; i < nx; i++)
+        {
+            out[n] = (struct RingRect){xs[i], ys[j], ws[i], hs[j], us[i], vs[j], us[i + 1], vs[j + 1]};
+            n++;
+        }
+    }
+    return n;
+}
+
+// clears a rectangle of the ring to transparent, so the layers below show through empty cells
+static void clear_rect(int px, int py, int pw, int ph)
+{
+    struct RingRect rects[4];
+    int n = wrap_rect(rects, px, py, pw, ph, 0, 0, 0, 0);
+    if (n == 0)
+        return;
+
+    struct FillVertex *v = (struct FillVertex *)sceGuGetMemory(n * 2 * sizeof(struct FillVertex));
+    for (int i = 0; i < n; i++)
+    {
+        v[i * 2 + 0] = (struct FillVertex){0x0000, rects[i].x, rects[i].y, 0};
+        v[i * 2 + 1] = (struct FillVertex){0x0000, rects[i].x + rects[i].w, rects[i].y + rects[i].h, 0};
+    }
+
+    sceGuDisable(GU_TEXTURE_2D);
+    fill_vertex_draw2d(GU_SPRITES, n * 2, NULL, v);
+    sceGuEnable(GU_TEXTURE_2D);
+}
+
+static void clear_column(int x)
+{
+    int left = ring_px(x * TILE_STEP_X);
+    clear_rect(left, 0, ring_px((x + 1) * TILE_STEP_X) - left, RING_SIZE);
+}
+
+static void clear_row(int y)
+{
+    int top = ring_py((y + 1) * TILE_STEP_Y);
+    clear_rect(0, top, RING_SIZE, ring_py(y * TILE_STEP_Y) - top);
+}
+
+// rasterizes the static tiles of a block of cells into the ring, animated tiles stay in the chunk meshes
+static unsigned int render_cells(const struct Tilemap *map, int x0, int y0, int x1, int y1)
+{
+    unsigned int cells = (x1 - x0 + 1) * (y1 - y0 + 1);
+    struct SpriteVertex *vertices = (struct SpriteVertex *)sceGuGetMemory(cells * 4 * 2 * sizeof(struct SpriteVertex));
+    struct SpriteVertex *v = vertices;
+    unsigned int tiles = 0;
+
+    for (int y = y0; y <= y1; y++)
+    {
+        for (int x = x0; x <= x1; x++)
+        {
+            unsigned int cell = y * map->width + x;
+            const struct TileProperties *tile = tile_props(map->grid.cells[cell]);
+            if (tile->layer == LAYER_NONE || tile->frames > 1)
+                continue;
+
+            int left = ring_px(x * TILE_STEP_X);
+            int right = ring_px(x * TILE_STEP_X + TILE_SIZE);
+            int top = ring_py(y * TILE_STEP_Y + TILE_SIZE);
+            int bottom = ring_py(y * TILE_STEP_Y);
+
+            // through mode texture coordinates are in texels
+            int u = tile->u * ATLAS_CELL;
+            int tv = (tile->v + tile_variant(tile, map->grid.neighbors[cell])) * ATLAS_CELL;
+
+            struct RingRect rects[4];
+            int n = wrap_rect(rects, left, top, right - left, bottom - top, u, tv, u + ATLAS_CELL, tv + ATLAS_CELL);
+            for (int i = 0; i < n; i++)
+            {
+                v[0] = (struct SpriteVertex){rects[i].u0, rects[i].v0, rects[i].x, rects[i].y, 0};
+                v[1] = (struct SpriteVertex){rects[i].u1, rects[i].v1, rects[i].x + rects[i].w, rects[i].y + rects[i].h, 0};
+                v += 2;
+            }
+            tiles++;
+        }
+    }
+
+    if (v != vertices)
+        sprite_vertex_draw2d(GU_SPRITES, v - vertices, NULL, vertices);
+    return tiles;
+}
+
+void scrollring_create(struct ScrollRing *ring, void *vram)
+{
+    ring->vram = vram;
+    ring->texture = (void *)(((unsigned int)vram) + ((unsigned int)sceGeEdramGetAddr()));
+    ring->source = NULL;
+    ring->revision = 0;
+    ring->valid = 0;
+    ring->x0 = ring->y0 = ring->x1 = ring->y1 = 0;
+    ring->camera_x = ring->camera_y = 0.0f;
+    ring->drawn_tiles = 0;
+}
+
+void scrollring_invalidate(struct ScrollRing *ring)
+{
+    ring->valid = 0;
+}
+
+static int clamp_cell(int value, unsigned int count)
+{
+    if (value < 0)
+        return 0;
+    if (value >= (int)count)
+        return count - 1;
+    return value;
+}
+
+void scrollring_update(struct ScrollRing *ring, const struct Tilemap *map, void *framebuffer)
+{
+    ring->drawn_tiles = 0;
+    ring->camera_x = map->camera_x;
+    ring->camera_y = map->camera_y;
+
+    if (map->width == 0 || map->height == 0)
+        return;
+
+    int x0 = clamp_cell(floor_int(map->camera_x / TILE_STEP_X), map->width);
+    int y0 = clamp_cell(floor_int(map->camera_y / TILE_STEP_Y), map->height);
+    int x1 = clamp_cell(floor_int((map->camera_x + VIEW_WORLD_W) / TILE_STEP_X), map->width);
+    int y1 = clamp_cell(floor_int((map->camera_y + VIEW_WORLD_H) / TILE_STEP_Y), map->height);
+
+    // a new map, edited cells or a jump past the old range redraw everything
+    int full = !ring->valid || ring->source != map || ring->revision != map->revision || x0 > ring->x1 || x1 < ring->x0 || y0 > ring->y1 || y1 < ring->y0;
+    if (!full && x0 == ring->x0 && x1 == ring->x1 && y0 == ring->y0 && y1 == ring->y1)
+        return;
+
+    sceGuDrawBufferList(RING_PSM, ring->vram, RING_SIZE);
+    sceGuScissor(0, 0, RING_SIZE, RING_SIZE);
+    sceGuDisable(GU_ALPHA_TEST);
+    sceGuDisable(GU_BLEND);
+    atlas_bind();
+    // the atlas alpha goes into the alpha bit of the ring, the vertices have no color to give one
+    sceGuTexFunc(GU_TFX_REPLACE, GU_TCC_RGBA);
+
+    if (full)
+    {
+        clear_rect(0, 0, RING_SIZE, RING_SIZE);
+        ring->drawn_tiles += render_cells(map, x0, y0, x1, y1);
+    }
+    else
+    {
+        // columns that came into view, for every visible row
+        for (int x = x0; x <= x1; x++)
+        {
+            if (x >= ring->x0 && x <= ring->x1)
+                continue;
+            clear_column(x);
+            ring->drawn_tiles += render_cells(map, x, y0, x, y1);
+        }
+
+        // rows that came into view, for every visible column
+        for (int y = y0; y <= y1; y++)
+        {
+            if (y >= ring->y0 && y <= ring->y1)
+                continue;
+            clear_row(y);
+            ring->drawn_tiles += render_cells(map, x0, y, x1, y);
+        }
+    }
+
+    ring->source = map;
+    ring->revision = map->revision;
+    ring->valid = 1;
+    ring->x0 = x0;
+    ring->y0 = y0;
+    ring->x1 = x1;
+    ring->y1 = y1;
+
+    // back to the screen, the ring is sampled as a texture from now on
+    sceGuDrawBufferList(GU_PSM_8888, framebuffer, PSP_BUF_WIDTH);
+    sceGuScissor(0, 0, PSP_SCR_WIDTH, PSP_SCR_HEIGHT);
+    sceGuTexFlush();
+}
+
+void scrollring_draw(struct ScrollRing *ring)
+{
+    if (!ring->valid)
+        return;
+
+    sceGuEnable(GU_TEXTURE_2D);
+    sceGuTexMode(RING_PSM, 0, 0, 0);
+    sceGuTexFunc(GU_TFX_REPLACE, GU_TCC_RGBA);
+    sceGuTexFilter(GU_NEAREST, GU_NEAREST);
+    sceGuTexWrap(GU_REPEAT, GU_REPEAT); // the view crosses the ring edges, repeat does the wrap
+    sceGuTexImage(0, RING_SIZE, RING_SIZE, RING_SIZE, ring->texture);
+
+    // cleared texels have no alpha, they let the backdrop through
+    sceGuEnable(GU_ALPHA_TEST);
+    sceGuAlphaFunc(GU_GREATER, 0, 0xFF);
+
+    int u = ring_px(ring->camera_x) & (RING_SIZE - 1);
+    int v = ring_py(ring->camera_y + VIEW_WORLD_H) & (RING_SIZE - 1);
+
+    int slices = (PSP_SCR_WIDTH + COMPOSITE_SLICE - 1) / COMPOSITE_SLICE;
+    struct SpriteVertex *vertices = (struct SpriteVertex *)sceGuGetMemory(slices * 2 * sizeof(struct SpriteVertex));
+
+    for (int i = 0; i < slices; i++)
+    {
+        int x = i * COMPOSITE_SLICE;
+        int w = x + COMPOSITE_SLICE > PSP_SCR_WIDTH ? PSP_SCR_WIDTH - x : COMPOSITE_SLICE;
+        vertices[i * 2 + 0] = (struct SpriteVertex){u + x, v, x, 0, 0};
+        vertices[i * 2 + 1] = (struct SpriteVertex){u + x + w, v + PSP_SCR_HEIGHT, x + w, PSP_SCR_HEIGHT, 0};
+    }
+
+    sprite_vertex_draw2d(GU_SPRITES, slices * 2, NULL, vertices);
+    sceGuDisable(GU_ALPHA_TEST);
+}
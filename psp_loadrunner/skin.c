@@ -0,0 +1,170 @@
+#include "headers/skin.h"
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __PSP__
+#include "headers/matrix.h"
+
+#include <pspgu.h>
+#include <pspkernel.h>
+#endif
+
+// byte offsets inside one target, the GE aligns each component to its own size
+static unsigned int uv_offset(unsigned int bones)
+{
+    return (bones + 3) & ~3u;
+}
+
+int skin_mesh_create(struct SkinMesh *mesh, unsigned int bones, unsigned int morphs, unsigned int vertex_count, unsigned int index_count)
+{
+    memset(mesh, 0, sizeof(*mesh));
+    if (bones < 1 || bones > SKIN_MAX_BONES || morphs < 1 || morphs > SKIN_MAX_MORPHS)
+        return -1;
+
+    mesh->bones = bones;
+    mesh->morphs = morphs;
+    mesh->stride = uv_offset(bones) + 5 * sizeof(float);
+    mesh->vertex_count = vertex_count;
+    mesh->index_count = index_count;
+
+    unsigned int bytes = vertex_count * morphs * mesh->stride;
+    mesh->vertices = (unsigned char *)memalign(16, bytes);
+    if (mesh->vertices == NULL)
+        return -1;
+    memset(mesh->vertices, 0, bytes);
+
+    if (index_count)
+    {
+        mesh->indices = (unsigned short *)memalign(16, index_count * sizeof(unsigned short));
+        if (mesh->indices == NULL)
+        {
+            free(mesh->vertices);
+            mesh->vertices = NULL;
+            return -1;
+        }
+        memset(mesh->indices, 0, index_count * sizeof(unsigned short));
+    }
+
+#ifdef __PSP__
+    mesh->vertex_flags = GU_WEIGHT_8BIT | GU_WEIGHTS(bones) | GU_VERTICES(morphs) | GU_TEXTURE_32BITF | GU_VERTEX_32BITF |
+                         (index_count ? GU_INDEX_16BIT : 0) | GU_TRANSFORM_3D;
+#endif
+    return 0;
+}
+
+void skin_mesh_destroy(struct SkinMesh *mesh)
+{
+    free(mesh->vertices);
+    free(mesh->indices);
+    mesh->vertices = NULL;
+    mesh->indices = NULL;
+}
+
+void skin_set_vertex(struct SkinMesh *mesh, unsigned int vertex, unsigned int morph, const float *weights,
+                     float u, float v, float x, float y, float z)
+{
+    unsigned char *target = mesh->vertices + (vertex * mesh->morphs + morph) * mesh->stride;
+
+    // negative weights count as 0 and the rest is scaled to add up to 128 before rounding, clamping
+    // each one on its own would let the sum drift and scale the vertex
+    float sum = 0.0f;
+    for (unsigned int i = 0; i < mesh->bones; i++)
+        sum += weights[i] > 0.0f ? weights[i] : 0.0f;
+    float scale = sum > 0.0f ? 128.0f / sum : 0.0f;
+
+    // round every weight, then give what rounding lost or added to the biggest one so they add up to 128.
+    // that is at most half a step per bone, the biggest weight is always larger
+    int total = 0, biggest = 0;
+    for (unsigned int i = 0; i < mesh->bones; i++)
+    {
+        int weight = weights[i] > 0.0f ? (int)(weights[i] * scale + 0.5f) : 0;
+        target[i] = weight;
+        total += weight;
+        if (weight > target[biggest])
+            biggest = i;
+    }
+    target[biggest] += 128 - total; // all 128 on the first bone when there was no weight at all
+
+    float *floats = (float *)(target + uv_offset(mesh->bones));
+    floats[0] = u;
+    floats[1] = v;
+    floats[2] = x;
+    floats[3] = y;
+    floats[4] = z;
+}
+
+void skin_mesh_flush(struct SkinMesh *mesh)
+{
+#ifdef __PSP__
+    // the GE reads both straight from RAM
+    sceKernelDcacheWritebackRange(mesh->vertices, mesh->vertex_count * mesh->morphs * mesh->stride);
+    if (mesh->indices)
+        sceKernelDcacheWritebackRange(mesh->indices, mesh->index_count * sizeof(unsigned short));
+#else
+    (void)mesh;
+#endif
+}
+
+void skin_pose_identity(struct SkinPose *pose)
+{
+    memset(pose, 0, sizeof(*pose));
+    for (int b = 0; b < SKIN_MAX_BONES; b++)
+        pose->bones[b][0] = pose->bones[b][5] = pose->bones[b][10] = pose->bones[b][15] = 1.0f;
+    pose->morph[0] = 1.0f;
+}
+
+void skin_cpu(const struct SkinMesh *mesh, const struct SkinPose *pose, struct BatchVertex *out)
+{
+    unsigned int bones = mesh->bones, morphs = mesh->morphs;
+    unsigned int floats_at = uv_offset(bones);
+
+    for (unsigned int i = 0; i < mesh->vertex_count; i++)
+    {
+        const unsigned char *targets = mesh->vertices + i * morphs * mesh->stride;
+
+        // mix the targets, weights included
+        float weights[SKIN_MAX_BONES] = {0.0f};
+        float mixed[5] = {0.0f};
+        for (unsigned int m = 0; m < morphs; m++)
+        {
+            const unsigned char *target = targets + m * mesh->stride;
+            const float *floats = (const float *)(target + floats_at);
+            float morph = pose->morph[m];
+            for (unsigned int b = 0; b < bones; b++)
+                weights[b] += target[b] * (1.0f / 128.0f) * morph;
+            for (int c = 0; c < 5; c++)
+                mixed[c] += floats[c] * morph;
+        }
+
+        // blend the bones, only their 4x3 part like the GE
+        float x = 0.0f, y = 0.0f, z = 0.0f;
+        for (unsigned int b = 0; b < bones; b++)
+        {
+            const float *m = pose->bones[b];
+            float w = weights[b];
+            if (w == 0.0f)
+                continue;
+            x += (m[0] * mixed[2] + m[4] * mixed[3] + m[8] * mixed[4] + m[12]) * w;
+            y += (m[1] * mixed[2] + m[5] * mixed[3] + m[9] * mixed[4] + m[13]) * w;
+            z += (m[2] * mixed[2] + m[6] * mixed[3] + m[10] * mixed[4] + m[14]) * w;
+        }
+
+        out[i] = (struct BatchVertex){mixed[0], mixed[1], 0xFFFFFFFF, x, y, z};
+    }
+}
+
+#ifdef __PSP__
+void skin_draw(const struct SkinMesh *mesh, const struct SkinPose *pose)
+{
+    for (unsigned int b = 0; b < mesh->bones; b++)
+        sceGuBoneMatrix(b, (const ScePspFMatrix4 *)pose->bones[b]);
+    for (unsigned int m = 0; m < mesh->morphs; m++)
+        sceGuMorphWeight(m, pose->morph[m]);
+
+    matrix_upload();
+    unsigned int count = mesh->index_count ? mesh->index_count : mesh->vertex_count;
+    sceGuDrawArray(GU_TRIANGLES, mesh->vertex_flags, count, mesh->indices, mesh->vertices);
+}
+#endif
@@ -0,0 +1,200 @@
+#include "headers/spritebatch.h"
+
+static const float identity[16] = {
+    1.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f,
+};
+
+// texture coordinates and color of the 4 corners of sprite i, positions are left to the caller
+static void write_attributes(const struct SpriteArrays *in, unsigned int i, struct BatchVertex *q)
+{
+    float u0 = in->u0[i], v0 = in->v0[i], u1 = in->u1[i], v1 = in->v1[i];
+    unsigned int color = in->color[i];
+
+    q[0].u = u0, q[0].v = v1, q[0].color = color;
+    q[1].u = u0, q[1].v = v0, q[1].color = color;
+    q[2].u = u1, q[2].v = v0, q[2].color = color;
+    q[3].u = u1, q[3].v = v1, q[3].color = color;
+}
+
+void batch_sprites_reference(const struct SpriteArrays *in, unsigned int count, struct BatchVertex *out, const float *transform)
+{
+    const float *m = transform ? transform : identity;
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        float left = in->x[i], bottom = in->y[i];
+        float right = left + in->w[i], top = bottom + in->h[i];
+        float xs[4] = {left, left, right, right};
+        float ys[4] = {bottom, top, top, bottom};
+
+        struct BatchVertex *q = out + i * 4;
+        write_attributes(in, i, q);
+
+        // same order of operations as the VFPU kernel: (x * column x + y * column y) + column w
+        for (int c = 0; c < 4; c++)
+        {
+            q[c].x = (xs[c] * m[0] + ys[c] * m[4]) + m[12];
+            q[c].y = (xs[c] * m[1] + ys[c] * m[5]) + m[13];
+            q[c].z = (xs[c] * m[2] + ys[c] * m[6]) + m[14];
+        }
+    }
+}
+
+#ifdef __PSP__
+// VFPU registers while the kernel runs:
+//   C100, C110       columns x and y of the transform
+//   C400, C410, C420 the translation x, y, z repeated 4 times
+//   C000, C010       left and bottom of 4 sprites, C020, C030 their right and top
+//   C200, C210, C220 x, y, z of one corner of the 4 sprites
+void batch_sprites(const struct SpriteArrays *in, unsigned int count, struct BatchVertex *out, const float *transform)
+{
+    const float *m = transform ? transform : identity;
+
+    __asm__ volatile(
+        "ulv.q   C100,  0(%0)\n"
+        "ulv.q   C110, 16(%0)\n"
+        "ulv.q   C130, 48(%0)\n"
+        "vone.q  C500\n"
+        "vscl.q  C400, C500, S130\n"
+        "vscl.q  C410, C500, S131\n"
+        "vscl.q  C420, C500, S132\n"
+        :
+        : "r"(m)
+        : "memory");
+
+    unsigned int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        struct BatchVertex *q = out + i * 4;
+        for (int j = 0; j < 4; j++)
+            write_attributes(in, i + j, q + j * 4);
+
+        __asm__ volatile(
+            "ulv.q   C000, 0(%1)\n"
+            "ulv.q   C010, 0(%2)\n"
+            "ulv.q   C020, 0(%3)\n"
+            "ulv.q   C030, 0(%4)\n"
+            "vadd.q  C020, C000, C020\n"
+            "vadd.q  C030, C010, C030\n"
+            // bottom left corner of the 4 sprites
+            "vscl.q  C200, C000, S100\n"
+            "vscl.q  C300, C010, S110\n"
+            "vadd.q  C200, C200, C300\n"
+            "vadd.q  C200, C200, C400\n"
+            "vscl.q  C210, C000, S101\n"
+            "vscl.q  C300, C010, S111\n"
+            "vadd.q  C210, C210, C300\n"
+            "vadd.q  C210, C210, C410\n"
+            "vscl.q  C220, C000, S102\n"
+            "vscl.q  C300, C010, S112\n"
+            "vadd.q  C220, C220, C300\n"
+            "vadd.q  C220, C220, C420\n"
+            "sv.s    S200, 12(%0)\n"
+            "sv.s    S210, 16(%0)\n"
+            "sv.s    S220, 20(%0)\n"
+            "sv.s    S201, 108(%0)\n"
+            "sv.s    S211, 112(%0)\n"
+            "sv.s    S221, 116(%0)\n"
+            "sv.s    S202, 204(%0)\n"
+            "sv.s    S212, 208(%0)\n"
+            "sv.s    S222, 212(%0)\n"
+            "sv.s    S203, 300(%0)\n"
+            "sv.s    S213, 304(%0)\n"
+            "sv.s    S223, 308(%0)\n"
+            // top left corner of the 4 sprites
+            "vscl.q  C200, C000, S100\n"
+            "vscl.q  C300, C030, S110\n"
+            "vadd.q  C200, C200, C300\n"
+            "vadd.q  C200, C200, C400\n"
+            "vscl.q  C210, C000, S101\n"
+            "vscl.q  C300, C030, S111\n"
+            "vadd.q  C210, C210, C300\n"
+            "vadd.q  C210, C210, C410\n"
+            "vscl.q  C220, C000, S102\n"
+            "vscl.q  C300, C030, S112\n"
+            "vadd.q  C220, C220, C300\n"
+            "vadd.q  C220, C220, C420\n"
+            "sv.s    S200, 36(%0)\n"
+            "sv.s    S210, 40(%0)\n"
+            "sv.s    S220, 44(%0)\n"
+            "sv.s    S201, 132(%0)\n"
+            "sv.s    S211, 136(%0)\n"
+            "sv.s    S221, 140(%0)\n"
+            "sv.s    S202, 228(%0)\n"
+            "sv.s    S212, 232(%0)\n"
+            "sv.s    S222, 236(%0)\n"
+            "sv.s    S203, 324(%0)\n"
+            "sv.s    S213, 328(%0)\n"
+            "sv.s    S223, 332(%0)\n"
+            // top right corner of the 4 sprites
+            "vscl.q  C200, C020, S100\n"
+            "vscl.q  C300, C030, S110\n"
+            "vadd.q  C200, C200, C300\n"
+            "vadd.q  C200, C200, C400\n"
+            "vscl.q  C210, C020, S101\n"
+            "vscl.q  C300, C030, S111\n"
+            "vadd.q  C210, C210, C300\n"
+            "vadd.q  C210, C210, C410\n"
+            "vscl.q  C220, C020, S102\n"
+            "vscl.q  C300, C030, S112\n"
+            "vadd.q  C220, C220, C300\n"
+            "vadd.q  C220, C220, C420\n"
+            "sv.s    S200, 60(%0)\n"
+            "sv.s    S210, 64(%0)\n"
+            "sv.s    S220, 68(%0)\n"
+            "sv.s    S201, 156(%0)\n"
+            "sv.s    S211, 160(%0)\n"
+            "sv.s    S221, 164(%0)\n"
+            "sv.s    S202, 252(%0)\n"
+            "sv.s    S212, 256(%0)\n"
+            "sv.s    S222, 260(%0)\n"
+            "sv.s    S203, 348(%0)\n"
+            "sv.s    S213, 352(%0)\n"
+            "sv.s    S223, 356(%0)\n"
+            // bottom right corner of the 4 sprites
+            "vscl.q  C200, C020, S100\n"
+            "vscl.q  C300, C010, S110\n"
+            "vadd.q  C200, C200, C300\n"
+            "vadd.q  C200, C200, C400\n"
+            "vscl.q  C210, C020, S101\n"
+            "vscl.q  C300, C010, S111\n"
+            "vadd.q  C210, C210, C300\n"
+            "vadd.q  C210, C210, C410\n"
+            "vscl.q  C220, C020, S102\n"
+            "vscl.q  C300, C010, S112\n"
+            "vadd.q  C220, C220, C300\n"
+            "vadd.q  C220, C220, C420\n"
+            "sv.s    S200, 84(%0)\n"
+            "sv.s    S210, 88(%0)\n"
+            "sv.s    S220, 92(%0)\n"
+            "sv.s    S201, 180(%0)\n"
+            "sv.s    S211, 184(%0)\n"
+            "sv.s    S221, 188(%0)\n"
+            "sv.s    S202, 276(%0)\n"
+            "sv.s    S212, 280(%0)\n"
+            "sv.s    S222, 284(%0)\n"
+            "sv.s    S203, 372(%0)\n"
+            "sv.s    S213, 376(%0)\n"
+            "sv.s    S223, 380(%0)\n"
+            :
+            : "r"(q), "r"(in->x + i), "r"(in->y + i), "r"(in->w + i), "r"(in->h + i)
+            : "memory");
+    }
+
+    // the last sprites when count is not a multiple of 4
+    if (i < count)
+    {
+        struct SpriteArrays tail = {in->x + i, in->y + i, in->w + i, in->h + i,
+                                    in->u0 + i, in->v0 + i, in->u1 + i, in->v1 + i, in->color + i};
+        batch_sprites_reference(&tail, count - i, out + i * 4, transform);
+    }
+}
+#else
+void batch_sprites(const struct SpriteArrays *in, unsigned int count, struct BatchVertex *out, const float *transform)
+{
+    batch_sprites_reference(in, count, out, transform);
+}
+#endif
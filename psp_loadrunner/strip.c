@@ -0,0 +1,238 @@
+#include "headers/strip.h"
+
+#include <stdlib.h>
+
+#ifdef __PSP__
+#include "headers/matrix.h"
+
+#include <pspgu.h>
+#endif
+
+// an edge of a triangle, a < b so both triangles sharing it store the same pair
+struct Edge
+{
+    unsigned short a, b;
+    unsigned int corner; // triangle * 3 + edge, edge e goes from corner e to corner (e + 1) % 3
+};
+
+static int edge_compare(const void *left, const void *right)
+{
+    const struct Edge *l = (const struct Edge *)left;
+    const struct Edge *r = (const struct Edge *)right;
+    if (l->a != r->a)
+        return l->a < r->a ? -1 : 1;
+    if (l->b != r->b)
+        return l->b < r->b ? -1 : 1;
+    return l->corner < r->corner ? -1 : (l->corner > r->corner);
+}
+
+// the triangle across every edge, -1 if none. an edge shared by more than two triangles only links the first two
+static int build_neighbors(const unsigned short *indices, unsigned int triangles, int *neighbors)
+{
+    struct Edge *edges = (struct Edge *)malloc(triangles * 3 * sizeof(struct Edge));
+    if (edges == NULL)
+        return -1;
+
+    for (unsigned int i = 0; i < triangles * 3; i++)
+    {
+        unsigned short a = indices[i];
+        unsigned short b = indices[i - i % 3 + (i + 1) % 3];
+        edges[i] = (struct Edge){a < b ? a : b, a < b ? b : a, i};
+        neighbors[i] = -1;
+    }
+    qsort(edges, triangles * 3, sizeof(struct Edge), edge_compare);
+
+    for (unsigned int i = 0; i + 1 < triangles * 3; i++)
+    {
+        if (edges[i].a != edges[i + 1].a || edges[i].b != edges[i + 1].b)
+            continue;
+        neighbors[edges[i].corner] = edges[i + 1].corner / 3;
+        neighbors[edges[i + 1].corner] = edges[i].corner / 3;
+
+        // skip the rest of the edge
+        unsigned int j = i + 1;
+        while (j + 1 < triangles * 3 && edges[j + 1].a == edges[i].a && edges[j + 1].b == edges[i].b)
+            j++;
+        i = j;
+    }
+
+    free(edges);
+    return 0;
+}
+
+// whether (x, y, z) is triangle t with the same winding
+static int same_triangle(const unsigned short *t, unsigned short x, unsigned short y, unsigned short z)
+{
+    return (t[0] == x && t[1] == y && t[2] == z) || (t[1] == x && t[2] == y && t[0] == z) || (t[2] == x && t[0] == y && t[1] == z);
+}
+
+struct Stripper
+{
+    const unsigned short *indices;
+    const int *neighbors;
+    unsigned char *used;  // triangles already in a strip
+    unsigned int *trial;  // triangles taken by the strip being measured, by trial number
+    unsigned int trial_id;
+};
+
+// follows the strip starting with corner `first` of triangle `start`, which sits at an even position.
+// returns how many triangles it takes. with out, their last index is written there (the strip from its 4th index
+// on) and they are marked used
+static unsigned int follow(struct Stripper *s, unsigned int start, unsigned int first, unsigned short *out)
+{
+    const unsigned short *t = s->indices + start * 3;
+    unsigned short u = t[(first + 1) % 3];
+    unsigned short v = t[(first + 2) % 3];
+    unsigned int current = start;
+    unsigned int count = 1;
+
+    s->trial_id++;
+    s->trial[start] = s->trial_id;
+    if (out)
+        s->used[start] = 1;
+
+    for (;;)
+    {
+        // the next triangle shares the edge u, v with the current one
+        int next = -1;
+        for (int e = 0; e < 3; e++)
+        {
+            const unsigned short *c = s->indices + current * 3;
+            unsigned short a = c[e], b = c[(e + 1) % 3];
+            if ((a == u && b == v) || (a == v && b == u))
+            {
+                next = s->neighbors[current * 3 + e];
+                break;
+            }
+        }
+        if (next < 0 || s->used[next] || s->trial[next] == s->trial_id)
+            break;
+
+        const unsigned short *n = s->indices + next * 3;
+        unsigned short w = n[0] != u && n[0] != v ? n[0] : (n[1] != u && n[1] != v ? n[1] : n[2]);
+
+        // odd triangles of a strip are drawn with their first two indices swapped
+        int odd = count & 1;
+        if (!same_triangle(n, odd ? v : u, odd ? u : v, w))
+            break;
+
+        if (out)
+        {
+            out[count - 1] = w;
+            s->used[next] = 1;
+        }
+        s->trial[next] = s->trial_id;
+        current = next;
+        u = v;
+        v = w;
+        count++;
+    }
+    return count;
+}
+
+int strip_build(const unsigned short *indices, unsigned int triangles, unsigned short *out)
+{
+    if (triangles == 0)
+        return 0;
+
+    int *neighbors = (int *)malloc(triangles * 3 * sizeof(int));
+    unsigned char *used = (unsigned char *)calloc(triangles, 1);
+    unsigned int *trial = (unsigned int *)calloc(triangles, sizeof(unsigned int));
+    if (neighbors == NULL || used == NULL || trial == NULL || build_neighbors(indices, triangles, neighbors) < 0)
+    {
+        free(neighbors);
+        free(used);
+        free(trial);
+        return -1;
+    }
+
+    struct Stripper s = {indices, neighbors, used, trial, 0};
+
+    unsigned int remaining = 0;
+    for (unsigned int i = 0; i < triangles; i++)
+    {
+        const unsigned short *t = indices + i * 3;
+        if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0])
+            used[i] = 1; // no area, nothing to draw
+        else
+            remaining++;
+    }
+
+    int length = 0;
+    while (remaining > 0)
+    {
+        // start where the fewest free neighbors are, strips starting in the middle of a mesh cut it in pieces
+        unsigned int start = 0;
+        int best_free = 4;
+        for (unsigned int i = 0; i < triangles && best_free > 0; i++)
+        {
+            if (used[i])
+                continue;
+            int free_neighbors = 0;
+            for (int e = 0; e < 3; e++)
+                free_neighbors += neighbors[i * 3 + e] >= 0 && !used[neighbors[i * 3 + e]];
+            if (free_neighbors < best_free)
+            {
+                best_free = free_neighbors;
+                start = i;
+            }
+        }
+
+        // the strip can leave the first triangle by any of its 3 edges, take the longest
+        unsigned int first = 0, best = 0;
+        for (unsigned int corner = 0; corner < 3; corner++)
+        {
+            unsigned int count = follow(&s, start, corner, NULL);
+            if (count > best)
+            {
+                best = count;
+                first = corner;
+            }
+        }
+
+        // join to the previous strip. the new one has to start at an even position to keep its winding
+        const unsigned short *t = indices + start * 3;
+        if (length > 0)
+        {
+            unsigned short last = out[length - 1];
+            if (length & 1)
+                out[length++] = last;
+            out[length++] = last;
+            out[length++] = t[first];
+        }
+
+        out[length++] = t[first];
+        out[length++] = t[(first + 1) % 3];
+        out[length++] = t[(first + 2) % 3];
+        follow(&s, start, first, out + length);
+        length += best - 1;
+
+        remaining -= best;
+    }
+
+    free(neighbors);
+    free(used);
+    free(trial);
+    return length;
+}
+
+#ifdef __PSP__
+void strip_draw(int vertex_flags, unsigned int count, const unsigned short *indices, const void *vertices)
+{
+    while (count >= 3)
+    {
+        unsigned int n = count < STRIP_DRAW_MAX ? count : STRIP_DRAW_MAX;
+
+        if (!(vertex_flags & GU_TRANSFORM_2D))
+            matrix_upload();
+        sceGuDrawArray(GU_TRIANGLE_STRIP, vertex_flags | GU_INDEX_16BIT, n, indices, vertices);
+
+        if (n == count)
+            break;
+
+        // the next draw starts with the last two indices of this one, at an even position
+        indices += n - 2;
+        count -= n - 2;
+    }
+}
+#endif
@@ -0,0 +1,217 @@
+#include "headers/tilegrid.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// tile flags double as mask bits, see tiles.h
+static unsigned int mask_bits_of(unsigned char tile)
+{
+    return tile_props(tile)->flags;
+}
+
+// neighbor offsets in the bit order of enum Neighbor, the opposite direction is 4 bits away
+static const signed char neighbor_dx[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+static const signed char neighbor_dy[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+
+// neighbor mask of one cell, cells outside of the level never match
+static unsigned char neighbors_of(const struct TileGrid *grid, unsigned int x, unsigned int y)
+{
+    unsigned char value = grid->cells[y * grid->width + x];
+    unsigned char bits = 0;
+
+    for (int i = 0; i < 8; i++)
+    {
+        unsigned int nx = x + neighbor_dx[i];
+        unsigned int ny = y + neighbor_dy[i];
+        if (nx < grid->width && ny < grid->height && grid->cells[ny * grid->width + nx] == value)
+            bits |= 1 << i;
+    }
+    return bits;
+}
+
+int tilegrid_create(struct TileGrid *grid, unsigned int width, unsigned int height)
+{
+    memset(grid, 0, sizeof(*grid));
+
+    grid->width = width;
+    grid->height = height;
+    grid->words_per_row = (width + 31) / 32;
+
+    unsigned int words = grid->words_per_row * height;
+
+    // the neighbor masks live right after the cells
+    grid->cells = (unsigned char *)calloc(width * height, 2);
+    // all the masks share one block, masks[0] owns it
+    unsigned int *block = (unsigned int *)calloc(words * MASK_COUNT, sizeof(unsigned int));
+
+    if (!grid->cells || !block)
+    {
+        free(block);
+        tilegrid_destroy(grid);
+        return -1;
+    }
+
+    for (int i = 0; i < MASK_COUNT; i++)
+        grid->masks[i] = block + i * words;
+
+    grid->neighbors = grid->cells + width * height;
+    tilegrid_rebuild_masks(grid);
+    return 0;
+}
+
+void tilegrid_destroy(struct TileGrid *grid)
+{
+    free(grid->cells);
+    free(grid->masks[0]);
+    memset(grid, 0, sizeof(*grid));
+}
+
+void tilegrid_set(struct TileGrid *grid, unsigned int x, unsigned int y, unsigned char value)
+{
+    if (x >= grid->width || y >= grid->height)
+        return;
+
+    grid->cells[y * grid->width + x] = value;
+
+    // only the cell and the matching bit of its 8 neighbors can change
+    unsigned char own = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        unsigned int nx = x + neighbor_dx[i];
+        unsigned int ny = y + neighbor_dy[i];
+        if (nx >= grid->width || ny >= grid->height)
+            continue;
+
+        unsigned int n = ny * grid->width + nx;
+        unsigned char back = 1 << ((i + 4) & 7);
+        if (grid->cells[n] == value)
+        {
+            own |= 1 << i;
+            grid->neighbors[n] |= back;
+        }
+        else
+        {
+            grid->neighbors[n] &= ~back;
+        }
+    }
+    grid->neighbors[y * grid->width + x] = own;
+
+    unsigned int word = y * grid->words_per_row + (x >> 5);
+    unsigned int bit = 1u << (x & 31);
+    unsigned int bits = mask_bits_of(value);
+
+    for (int i = 0; i < MASK_COUNT; i++)
+    {
+        unsigned int set = -((bits >> i) & 1); // all ones when the tile has the property
+        grid->masks[i][word] = (grid->masks[i][word] & ~bit) | (set & bit);
+    }
+}
+
+void tilegrid_rebuild_masks(struct TileGrid *grid)
+{
+    memset(grid->masks[0], 0, grid->words_per_row * grid->height * MASK_COUNT * sizeof(unsigned int));
+
+    for (unsigned int y = 0; y < grid->height; y++)
+    {
+        for (unsigned int x = 0; x < grid->width; x++)
+        {
+            unsigned int bits = mask_bits_of(grid->cells[y * grid->width + x]);
+            unsigned int word = y * grid->words_per_row + (x >> 5);
+
+            for (int i = 0; i < MASK_COUNT; i++)
+                grid->masks[i][word] |= ((bits >> i) & 1) << (x & 31);
+
+            grid->neighbors[y * grid->width + x] = neighbors_of(grid, x, y);
+        }
+    }
+}
+
+// is any cell of column x, rows y0 .. y1, in the mask
+static int column_hits(const struct TileGrid *grid, enum TileMask mask, int x, int y0, int y1)
+{
+    for (int y = y0; y <= y1; y++)
+    {
+        if (tilegrid_test(grid, mask, x, y))
+            return 1;
+    }
+    return 0;
+}
+
+int tilegrid_move_box(const struct TileGrid *grid, enum TileMask mask, struct FixedAABB *box, struct FixedVec2 delta)
+{
+    int hits = 0;
+
+    // max is exclusive, the last cell a box covers is the one of max - 1
+    if (delta.x != 0)
+    {
+        int y0 = fixed_floor(box->min.y);
+        int y1 = fixed_floor(box->max.y - 1);
+
+        if (delta.x > 0)
+        {
+            int last = fixed_floor(box->max.x + delta.x - 1);
+            for (int x = fixed_floor(box->max.x - 1) + 1; x <= last; x++)
+            {
+                if (column_hits(grid, mask, x, y0, y1))
+                {
+                    delta.x = fixed_from_int(x) - box->max.x;
+                    hits |= HIT_RIGHT;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            int last = fixed_floor(box->min.x + delta.x);
+            for (int x = fixed_floor(box->min.x) - 1; x >= last; x--)
+            {
+                if (column_hits(grid, mask, x, y0, y1))
+                {
+                    delta.x = fixed_from_int(x + 1) - box->min.x;
+                    hits |= HIT_LEFT;
+                    break;
+                }
+            }
+        }
+        box->min.x += delta.x;
+        box->max.x += delta.x;
+    }
+
+    // rows are tested with the bitboards, a whole span of the box at once
+    if (delta.y != 0)
+    {
+        int x0 = fixed_floor(box->min.x);
+        int count = fixed_floor(box->max.x - 1) - x0 + 1;
+
+        if (delta.y > 0)
+        {
+            int last = fixed_floor(box->max.y + delta.y - 1);
+            for (int y = fixed_floor(box->max.y - 1) + 1; y <= last; y++)
+            {
+                if (tilegrid_any(grid, mask, x0, y, count))
+                {
+                    delta.y = fixed_from_int(y) - box->max.y;
+                    hits |= HIT_UP;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            int last = fixed_floor(box->min.y + delta.y);
+            for (int y = fixed_floor(box->min.y) - 1; y >= last; y--)
+            {
+                if (tilegrid_any(grid, mask, x0, y, count))
+                {
+                    delta.y = fixed_from_int(y + 1) - box->min.y;
+                    hits |= HIT_DOWN;
+                    break;
+                }
+            }
+        }
+        box->min.y += delta.y;
+        box->max.y += delta.y;
+    }
+
+    return hits;
+}
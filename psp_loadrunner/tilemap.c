@@ -0,0 +1,338 @@
+#include "headers/tilemap.h"
+#include "headers/atlas.h"
+
+#include <pspgu.h>
+#include <stdlib.h>
+#include <string.h>
+
+// every chunk loses its mesh and gets a fresh one on its next draw
+static void reset_meshes(struct Tilemap *map)
+{
+    for (unsigned int i = 0; i < map->chunks_x * map->chunks_y; i++)
+    {
+        map->chunk_mesh[i] = -1;
+        map->chunk_dirty[i] = 1;
+    }
+
+    for (unsigned int i = 0; i < map->mesh_count; i++)
+    {
+        map->meshes[i].quad_count = 0;
+        map->meshes[i].owner = -1;
+    }
+}
+
+int tilemap_create(struct Tilemap *map, unsigned int width, unsigned int height)
+{
+    struct TileGrid grid;
+    if (tilegrid_create(&grid, width, height) < 0)
+        return -1;
+    return tilemap_create_from_grid(map, &grid);
+}
+
+int tilemap_create_from_grid(struct Tilemap *map, struct TileGrid *grid)
+{
+    memset(map, 0, sizeof(*map));
+
+    // the tilemap takes over the grid memory
+    map->grid = *grid;
+    memset(grid, 0, sizeof(*grid));
+
+    map->width = map->grid.width;
+    map->height = map->grid.height;
+    map->chunks_x = (map->width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    map->chunks_y = (map->height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    unsigned int chunk_count = map->chunks_x * map->chunks_y;
+
+    map->chunk_mesh = (short *)malloc(chunk_count * sizeof(short));
+    map->chunk_dirty = (unsigned char *)malloc(chunk_count);
+    // small maps (HUD, backdrops) never need more meshes than they have chunks
+    map->mesh_count = chunk_count < TILEMAP_MAX_MESHES ? chunk_count : TILEMAP_MAX_MESHES;
+    // RAM only, levelstream builds maps on its loader thread and the EDRAM blocks are main thread only
+    if (gpubuffer_create(&map->mesh_buffer, map->mesh_count * sizeof(struct ChunkMesh), BUFFER_RAM) == 0)
+        map->meshes = (struct ChunkMesh *)map->mesh_buffer.cpu;
+
+    map->scroll_factor = 1.0f;
+    map->update_interval = 1;
+    map->draw_static = 1;
+
+    if (!map->chunk_mesh || !map->chunk_dirty || !map->meshes)
+    {
+        tilemap_destroy(map);
+        return -1;
+    }
+
+    reset_meshes(map);
+
+    // chunk meshes are lists of quads drawn with the shared quad indices
+    quads_init();
+
+    return 0;
+}
+
+void tilemap_destroy(struct Tilemap *map)
+{
+    tilegrid_destroy(&map->grid);
+    free(map->chunk_mesh);
+    free(map->chunk_dirty);
+    gpubuffer_destroy(&map->mesh_buffer);
+    memset(map, 0, sizeof(*map));
+}
+
+int tilemap_place_meshes(struct Tilemap *map, enum BufferPlacement placement)
+{
+    struct GpuBuffer buffer;
+    if (gpubuffer_create(&buffer, map->mesh_count * sizeof(struct ChunkMesh), placement) < 0)
+        return -1;
+
+    gpubuffer_destroy(&map->mesh_buffer);
+    map->mesh_buffer = buffer;
+    map->meshes = (struct ChunkMesh *)buffer.cpu;
+    reset_meshes(map);
+    return 0;
+}
+
+unsigned char tilemap_get_cell(const struct Tilemap *map, unsigned int x, unsigned int y)
+{
+    return tilegrid_get(&map->grid, x, y);
+}
+
+void tilemap_set_cell(struct Tilemap *map, unsigned int x, unsigned int y, unsigned char value)
+{
+    if (x >= map->width || y >= map->height)
+        return;
+
+    if (tilegrid_get(&map->grid, x, y) == value)
+        return;
+
+    tilegrid_set(&map->grid, x, y, value);
+    map->revision++;
+
+    // the neighbors may pick another autotile variant, on a chunk border they belong to the next chunk
+    unsigned int cx0 = (x > 0 ? x - 1 : 0) / CHUNK_SIZE;
+    unsigned int cy0 = (y > 0 ? y - 1 : 0) / CHUNK_SIZE;
+    unsigned int cx1 = (x + 1 < map->width ? x + 1 : x) / CHUNK_SIZE;
+    unsigned int cy1 = (y + 1 < map->height ? y + 1 : y) / CHUNK_SIZE;
+    for (unsigned int cy = cy0; cy <= cy1; cy++)
+        for (unsigned int cx = cx0; cx <= cx1; cx++)
+            map->chunk_dirty[cy * map->chunks_x + cx] = 1;
+}
+
+void tilemap_set_camera(struct Tilemap *map, float x, float y)
+{
+    map->camera_x = x;
+    map->camera_y = y;
+}
+
+static float wrap(float value, float period)
+{
+    if (period <= 0.0f)
+        return value;
+    value -= (int)(value / period) * period;
+    return value < 0.0f ? value + period : value;
+}
+
+void tilemap_follow(struct Tilemap *map, float x, float y)
+{
+    map->camera_x = wrap(x * map->scroll_factor, map->wrap_w);
+    map->camera_y = wrap(y * map->scroll_factor, map->wrap_h);
+}
+
+// animated tiles are grouped by tile value, everything else shares group 0
+static unsigned int anim_group(const struct TileProperties *tile, unsigned char value)
+{
+    return tile->frames > 1 ? TILE_INDEX(value) : 0;
+}
+
+// fills the mesh with the quads of one chunk, positions are relative to the chunk origin
+static void build_chunk_mesh(struct Tilemap *map, struct ChunkMesh *mesh, unsigned int cx, unsigned int cy)
+{
+    unsigned int x0 = cx * CHUNK_SIZE;
+    unsigned int y0 = cy * CHUNK_SIZE;
+    unsigned int x1 = x0 + CHUNK_SIZE < map->width ? x0 + CHUNK_SIZE : map->width;
+    unsigned int y1 = y0 + CHUNK_SIZE < map->height ? y0 + CHUNK_SIZE : map->height;
+
+    // first pass counts the quads of every group so they can be written contiguously
+    unsigned short next[TILE_TABLE_SIZE];
+    memset(mesh->group_count, 0, sizeof(mesh->group_count));
+
+    for (unsigned int y = y0; y < y1; y++)
+    {
+        for (unsigned int x = x0; x < x1; x++)
+        {
+            unsigned char value = map->grid.cells[y * map->width + x];
+            const struct TileProperties *tile = tile_props(value);
+            if (tile->layer != LAYER_NONE)
+                mesh->group_count[anim_group(tile, value)]++;
+        }
+    }
+
+    int quads = 0;
+    for (int g = 0; g < TILE_TABLE_SIZE; g++)
+    {
+        mesh->group_start[g] = next[g] = quads;
+        quads += mesh->group_count[g];
+    }
+
+    for (unsigned int y = y0; y < y1; y++)
+    {
+        for (unsigned int x = x0; x < x1; x++)
+        {
+            unsigned int cell = y * map->width + x;
+            unsigned char value = map->grid.cells[cell];
+            const struct TileProperties *tile = tile_props(value);
+            if (tile->layer == LAYER_NONE)
+                continue;
+
+            short left = vertex_pos16(TILE_STEP_X * (x - x0));
+            short bottom = vertex_pos16(TILE_STEP_Y * (y - y0));
+            short right = vertex_pos16(TILE_STEP_X * (x - x0) + TILE_SIZE);
+            short top = vertex_pos16(TILE_STEP_Y * (y - y0) + TILE_SIZE);
+            short depth = vertex_pos16(-1.0f);
+
+            // frame 0 of the tile, the texture offset picks the other frames. autotiles pick their
+            // variant from the neighbor mask the grid keeps, no neighbor is looked at here
+            unsigned char u0 = vertex_uv8(tile->u * ATLAS_CELL_U);
+            unsigned char v0 = vertex_uv8((tile->v + tile_variant(tile, map->grid.neighbors[cell])) * ATLAS_CELL_V);
+            unsigned char u1 = u0 + vertex_uv8(ATLAS_CELL_U);
+            unsigned char v1 = v0 + vertex_uv8(ATLAS_CELL_V);
+
+            // counter clockwise construction, same order as the quad indices (quads.h). texture rows go down
+            struct TileVertex *q = &mesh->vertices[next[anim_group(tile, value)]++ * 4];
+            q[0] = (struct TileVertex){u0, v1, left, bottom, depth};
+            q[1] = (struct TileVertex){u0, v0, left, top, depth};
+            q[2] = (struct TileVertex){u1, v0, right, top, depth};
+            q[3] = (struct TileVertex){u1, v1, right, bottom, depth};
+        }
+    }
+
+    mesh->quad_count = quads;
+
+    // the GE reads the vertices straight from memory
+    gpubuffer_flush(&map->mesh_buffer, (unsigned char *)mesh->vertices - (unsigned char *)map->meshes,
+                    quads * 4 * sizeof(struct TileVertex));
+}
+
+// finds a mesh slot that is free or owned by a chunk outside of the visible range
+static int acquire_mesh(struct Tilemap *map, unsigned int cx0, unsigned int cy0, unsigned int cx1, unsigned int cy1)
+{
+    for (unsigned int i = 0; i < map->mesh_count; i++)
+    {
+        int owner = map->meshes[i].owner;
+        if (owner < 0)
+            return i;
+
+        unsigned int ox = owner % map->chunks_x;
+        unsigned int oy = owner / map->chunks_x;
+        if (ox < cx0 || ox > cx1 || oy < cy0 || oy > cy1)
+        {
+            map->chunk_mesh[owner] = -1;
+            map->meshes[i].owner = -1;
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int world_to_chunk(float value, float chunk_size, unsigned int count)
+{
+    int c = (int)(value / chunk_size);
+    if (value < 0.0f)
+        c = -1;
+    if (c >= (int)count)
+        c = count - 1;
+    return c;
+}
+
+void tilemap_draw(struct Tilemap *map, unsigned int ticks)
+{
+    map->drawn_chunks = 0;
+
+    if (map->camera_x + VIEW_WORLD_W <= 0.0f || map->camera_y + VIEW_WORLD_H <= 0.0f)
+        return;
+
+    // chunks intersecting the camera view, nothing outside of it gets a mesh or a draw call
+    int cx0 = world_to_chunk(map->camera_x, CHUNK_WORLD_W, map->chunks_x);
+    int cy0 = world_to_chunk(map->camera_y, CHUNK_WORLD_H, map->chunks_y);
+    int cx1 = world_to_chunk(map->camera_x + VIEW_WORLD_W, CHUNK_WORLD_W, map->chunks_x);
+    int cy1 = world_to_chunk(map->camera_y + VIEW_WORLD_H, CHUNK_WORLD_H, map->chunks_y);
+    if (cx0 < 0)
+        cx0 = 0;
+    if (cy0 < 0)
+        cy0 = 0;
+    if (cx1 < cx0 || cy1 < cy0)
+        return;
+
+    // a layer only rebuilds changed chunks and steps its animations on its own update frames,
+    // in between it keeps drawing what it has
+    int update = map->update_interval && ticks % map->update_interval == 0;
+    unsigned int anim_ticks = map->update_interval ? ticks - ticks % map->update_interval : 0;
+
+    // static geometry never changes for animations, only the texture offset of the group does.
+    // animation frames are stretched to whole update intervals (8 ticks with an interval of 30 last 30),
+    // sampling shorter ones at the interval would alias (they would look frozen or step at random)
+    float group_offset[TILE_TABLE_SIZE];
+    for (int g = 0; g < TILE_TABLE_SIZE; g++)
+    {
+        const struct TileProperties *tile = &tile_properties[g];
+        unsigned int period = tile->ticks;
+        if (map->update_interval > 1)
+            period = (period + map->update_interval - 1) / map->update_interval * map->update_interval;
+        unsigned int frame = tile->frames > 1 && period ? (anim_ticks / period) % tile->frames : 0;
+        group_offset[g] = frame * ATLAS_CELL_V;
+    }
+
+    atlas_bind();
+
+    for (int cy = cy0; cy <= cy1; cy++)
+    {
+        for (int cx = cx0; cx <= cx1; cx++)
+        {
+            unsigned int chunk = cy * map->chunks_x + cx;
+            int slot = map->chunk_mesh[chunk];
+            int fresh = 0;
+
+            if (slot < 0)
+            {
+                slot = acquire_mesh(map, cx0, cy0, cx1, cy1);
+                if (slot < 0)
+                    continue; // pool smaller than the view, see TILEMAP_MAX_MESHES
+
+                map->meshes[slot].owner = chunk;
+                map->chunk_mesh[chunk] = slot;
+                map->chunk_dirty[chunk] = 1;
+                fresh = 1;
+            }
+
+            struct ChunkMesh *mesh = &map->meshes[slot];
+            if (map->chunk_dirty[chunk] && (update || fresh))
+            {
+                build_chunk_mesh(map, mesh, cx, cy);
+                map->chunk_dirty[chunk] = 0;
+            }
+
+            if (mesh->quad_count == 0)
+                continue;
+
+            // the projection has its origin in the middle of the screen, move it to the bottom left
+            matrix_mode(GU_MODEL);
+            matrix_identity();
+            matrix_translate(-16.0f / 9.0f + cx * CHUNK_WORLD_W - map->camera_x,
+                             -1.0f + cy * CHUNK_WORLD_H - map->camera_y,
+                             0.0f);
+            matrix_scale(VERTEX_POS16_RANGE, VERTEX_POS16_RANGE, VERTEX_POS16_RANGE); // 16 bit positions are fractions of the range
+
+            for (int g = 0; g < TILE_TABLE_SIZE; g++)
+            {
+                if (mesh->group_count[g] == 0 || (g == 0 && !map->draw_static))
+                    continue;
+
+                sceGuTexOffset(0.0f, group_offset[g]);
+                tile_vertex_draw_quads3d(mesh->group_count[g], mesh->vertices + mesh->group_start[g] * 4);
+            }
+            map->drawn_chunks++;
+        }
+    }
+
+    sceGuTexOffset(0.0f, 0.0f);
+}
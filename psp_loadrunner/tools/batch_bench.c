@@ -0,0 +1,165 @@
+// Correctness check and throughput of the sprite batch kernels (spritebatch.h)
+//
+// on the host only the C reference runs, build and run from psp_loadrunner/ with your host compiler:
+//     gcc -O2 -o batch_bench tools/batch_bench.c spritebatch.c
+//     ./batch_bench
+//
+// on the PSP the VFPU kernel is checked against the reference and both are timed. build it as an ELF
+// and start it with psplink:
+//     PSPSDK=$(psp-config --pspsdk-path)
+//     psp-gcc -D__PSP__ -O2 -G0 -I$PSPSDK/include -L$PSPSDK/lib -o batch_bench.elf
+//         tools/batch_bench.c spritebatch.c -lpspdebug -lpspuser -lpspkernel
+//     ./batch_bench.elf
+
+#include "../headers/spritebatch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __PSP__
+#include <pspkernel.h>
+
+PSP_MODULE_INFO("batch_bench", 0, 1, 1);
+PSP_MAIN_THREAD_ATTR(THREAD_ATTR_USER | THREAD_ATTR_VFPU);
+
+static double now_seconds()
+{
+    return sceKernelGetSystemTimeLow() / 1e6;
+}
+#else
+#include <time.h>
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+#endif
+
+#define SPRITES (4095) // not a multiple of 4, so the tail path runs too
+#define ITERATIONS (200)
+
+static float xs[SPRITES], ys[SPRITES], ws[SPRITES], hs[SPRITES];
+static float u0s[SPRITES], v0s[SPRITES], u1s[SPRITES], v1s[SPRITES];
+static unsigned int colors[SPRITES];
+static struct BatchVertex reference[SPRITES * 4], kernel[SPRITES * 4];
+
+// the ortho projection of the game followed by the viewport, world units to screen pixels
+static const float to_pixels[16] = {
+    480.0f / (32.0f / 9.0f), 0.0f, 0.0f, 0.0f,
+    0.0f, -272.0f / 2.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    240.0f, 136.0f, 0.0f, 1.0f,
+};
+
+static float random_float(float min, float max)
+{
+    return min + (max - min) * (rand() / (float)RAND_MAX);
+}
+
+static int close_to(float a, float b)
+{
+    float d = a > b ? a - b : b - a;
+    float m = a > 0.0f ? a : -a;
+    return d <= 1e-4f + m * 1e-5f; // the VFPU is not bit exact with the FPU
+}
+
+static int compare(const struct BatchVertex *a, const struct BatchVertex *b, unsigned int count, const char *what)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (a[i].u != b[i].u || a[i].v != b[i].v || a[i].color != b[i].color ||
+            !close_to(a[i].x, b[i].x) || !close_to(a[i].y, b[i].y) || !close_to(a[i].z, b[i].z))
+        {
+            printf("%s: vertex %u differs: (%f %f %f) vs (%f %f %f)\n", what, i, a[i].x, a[i].y, a[i].z, b[i].x, b[i].y, b[i].z);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// the reference itself against numbers worked out by hand
+static int check_reference()
+{
+    float x = 1.0f, y = 0.5f, w = 0.125f, h = 0.25f;
+    float u0 = 0.25f, v0 = 0.0f, u1 = 0.375f, v1 = 0.25f;
+    unsigned int color = 0xFF00D7FF;
+    struct SpriteArrays one = {&x, &y, &w, &h, &u0, &v0, &u1, &v1, &color};
+    struct BatchVertex q[4];
+
+    batch_sprites_reference(&one, 1, q, NULL);
+    struct BatchVertex expected[4] = {
+        {0.25f, 0.25f, 0xFF00D7FF, 1.0f, 0.5f, 0.0f},
+        {0.25f, 0.0f, 0xFF00D7FF, 1.0f, 0.75f, 0.0f},
+        {0.375f, 0.0f, 0xFF00D7FF, 1.125f, 0.75f, 0.0f},
+        {0.375f, 0.25f, 0xFF00D7FF, 1.125f, 0.5f, 0.0f},
+    };
+    if (!compare(q, expected, 4, "reference, no transform"))
+        return 0;
+
+    // world (0, 0) is the middle of the screen, y goes down in pixels
+    x = 0.0f, y = 0.0f, w = 32.0f / 9.0f / 480.0f * 16.0f, h = 2.0f / 272.0f * 8.0f;
+    batch_sprites_reference(&one, 1, q, to_pixels);
+    struct BatchVertex pixels[4] = {
+        {0.25f, 0.25f, 0xFF00D7FF, 240.0f, 136.0f, 0.0f},
+        {0.25f, 0.0f, 0xFF00D7FF, 240.0f, 128.0f, 0.0f},
+        {0.375f, 0.0f, 0xFF00D7FF, 256.0f, 128.0f, 0.0f},
+        {0.375f, 0.25f, 0xFF00D7FF, 256.0f, 136.0f, 0.0f},
+    };
+    return compare(q, pixels, 4, "reference, to pixels");
+}
+
+static double time_batches(void (*batch)(const struct SpriteArrays *, unsigned int, struct BatchVertex *, const float *),
+                           const struct SpriteArrays *in, struct BatchVertex *out, const float *transform)
+{
+    double start = now_seconds();
+    for (int i = 0; i < ITERATIONS; i++)
+        batch(in, SPRITES, out, transform);
+    return now_seconds() - start;
+}
+
+int main()
+{
+    srand(1);
+    for (int i = 0; i < SPRITES; i++)
+    {
+        xs[i] = random_float(-2.0f, 2.0f);
+        ys[i] = random_float(-1.0f, 1.0f);
+        ws[i] = random_float(0.05f, 0.2f);
+        hs[i] = random_float(0.05f, 0.2f);
+        u0s[i] = (rand() % 8) / 8.0f;
+        v0s[i] = (rand() % 4) / 4.0f;
+        u1s[i] = u0s[i] + 0.125f;
+        v1s[i] = v0s[i] + 0.25f;
+        colors[i] = 0xFF000000 | rand();
+    }
+    struct SpriteArrays in = {xs, ys, ws, hs, u0s, v0s, u1s, v1s, colors};
+
+    int ok = check_reference();
+
+    const float *transforms[2] = {NULL, to_pixels};
+    const char *names[2] = {"world", "pixels"};
+    for (int t = 0; t < 2; t++)
+    {
+        batch_sprites_reference(&in, SPRITES, reference, transforms[t]);
+        memset(kernel, 0, sizeof(kernel));
+        batch_sprites(&in, SPRITES, kernel, transforms[t]);
+        ok = compare(reference, kernel, SPRITES * 4, names[t]) && ok;
+
+        double ref_s = time_batches(batch_sprites_reference, &in, reference, transforms[t]);
+        double kernel_s = time_batches(batch_sprites, &in, kernel, transforms[t]);
+        double sprites = (double)SPRITES * ITERATIONS;
+        printf("%-6s reference: %8.2f Msprites/s (%7.1f MB/s of vertices)\n", names[t],
+               sprites / ref_s / 1e6, sprites * 4 * sizeof(struct BatchVertex) / ref_s / 1e6);
+        printf("%-6s batch:     %8.2f Msprites/s (%7.1f MB/s of vertices)\n", names[t],
+               sprites / kernel_s / 1e6, sprites * 4 * sizeof(struct BatchVertex) / kernel_s / 1e6);
+    }
+
+    printf(ok ? "all vertices match\n" : "MISMATCH\n");
+#ifdef __PSP__
+    sceKernelExitGame();
+#endif
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,255 @@
+// Determinism check and speed of the 16.16 fixed point simulation (fixed.h) against the same thing in floats
+//
+// on the host, build and run from psp_loadrunner/ with your host compiler:
+//     gcc -O2 -o fixed_bench tools/fixed_bench.c fixed.c tilegrid.c -lm
+//     ./fixed_bench
+//
+// on the PSP build it as an ELF and start it with psplink:
+//     PSPSDK=$(psp-config --pspsdk-path)
+//     psp-gcc -D__PSP__ -O2 -G0 -I$PSPSDK/include -L$PSPSDK/lib -o fixed_bench.elf
+//         tools/fixed_bench.c fixed.c tilegrid.c -lm -lpspdebug -lpspuser -lpspkernel
+//     ./fixed_bench.elf
+//
+// runners walk, fall and bounce through a generated level for STEPS frames. the checksum of the fixed
+// point run has to be SIM_CHECKSUM everywhere, the float run is only there to compare the time.
+// on the host the two times are within noise of each other and either one can come out ahead from run
+// to run or machine to machine, fixed point is there for determinism. only times taken on the PSP say
+// anything about the game
+
+#include "../headers/tilegrid.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifdef __PSP__
+#include <pspkernel.h>
+
+PSP_MODULE_INFO("fixed_bench", 0, 1, 1);
+PSP_MAIN_THREAD_ATTR(THREAD_ATTR_USER | THREAD_ATTR_VFPU);
+
+static double now_seconds()
+{
+    return sceKernelGetSystemTimeLow() / 1e6;
+}
+#else
+#include <time.h>
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+#endif
+
+#define LEVEL_W (28)
+#define LEVEL_H (17)
+#define RUNNERS (64)
+#define STEPS (20000)
+
+// checksum of the fixed point run on the host, the PSP has to print the same
+#define SIM_CHECKSUM (0x80346baau)
+
+// same numbers for both runs, the float ones are converted from these
+#define RUNNER_W FIXED_CONST(0.75)
+#define RUNNER_H FIXED_CONST(0.875)
+#define RUN_SPEED FIXED_CONST(0.0625)
+#define GRAVITY FIXED_CONST(0.015625)
+#define MAX_FALL FIXED_CONST(0.5)
+#define JUMP FIXED_CONST(0.25)
+
+struct FixedRunner
+{
+    struct FixedAABB box;
+    struct FixedVec2 velocity;
+    unsigned int angle; // walking direction, turned back on every wall hit
+};
+
+struct FloatRunner
+{
+    float x0, y0, x1, y1;
+    float vx, vy;
+    float angle; // radians
+};
+
+static unsigned int random_state = 12345;
+
+static unsigned int next_random()
+{
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 16;
+}
+
+static void build_level(struct TileGrid *grid)
+{
+    tilegrid_create(grid, LEVEL_W, LEVEL_H);
+    for (unsigned int y = 0; y < LEVEL_H; y++)
+    {
+        for (unsigned int x = 0; x < LEVEL_W; x++)
+        {
+            int border = x == 0 || y == 0 || x == LEVEL_W - 1 || y == LEVEL_H - 1;
+            int floor = y % 4 == 0 && next_random() % 5 != 0;
+            tilegrid_set(grid, x, y, border ? TILE_CONCRETE : (floor ? TILE_BRICK : TILE_EMPTY));
+        }
+    }
+}
+
+static void step_fixed(const struct TileGrid *grid, struct FixedRunner *runners)
+{
+    for (int i = 0; i < RUNNERS; i++)
+    {
+        struct FixedRunner *r = runners + i;
+        r->velocity.x = fixed_mul(fixed_cos(r->angle), RUN_SPEED);
+        r->velocity.y = fixed_max(r->velocity.y - GRAVITY, -MAX_FALL);
+
+        int hits = tilegrid_move_box(grid, MASK_SOLID, &r->box, r->velocity);
+        if (hits & (HIT_LEFT | HIT_RIGHT))
+            r->angle = (r->angle + FIXED_ANGLE(150)) & (FIXED_TURN - 1);
+        if (hits & HIT_DOWN)
+            r->velocity.y = fixed_mul(JUMP, fixed_abs(fixed_sin(r->angle)));
+        if (hits & HIT_UP)
+            r->velocity.y = 0;
+    }
+}
+
+// the float version of tilegrid_move_box, the same steps with floats in place of shifts
+static int column_solid(const struct TileGrid *grid, int x, int y0, int y1)
+{
+    for (int y = y0; y <= y1; y++)
+    {
+        if (tilegrid_test(grid, MASK_SOLID, x, y))
+            return 1;
+    }
+    return 0;
+}
+
+static int floor_int(float value)
+{
+    int i = (int)value;
+    return value < (float)i ? i - 1 : i;
+}
+
+static int move_float(const struct TileGrid *grid, struct FloatRunner *r, float dx, float dy)
+{
+    const float edge = 1.0f / 65536.0f; // max is exclusive, like the fixed boxes
+    int hits = 0;
+
+    int y0 = floor_int(r->y0), y1 = floor_int(r->y1 - edge);
+    if (dx > 0.0f)
+    {
+        for (int x = floor_int(r->x1 - edge) + 1; x <= floor_int(r->x1 + dx - edge); x++)
+            if (column_solid(grid, x, y0, y1))
+            {
+                dx = x - r->x1;
+                hits |= HIT_RIGHT;
+                break;
+            }
+    }
+    else if (dx < 0.0f)
+    {
+        for (int x = floor_int(r->x0) - 1; x >= floor_int(r->x0 + dx); x--)
+            if (column_solid(grid, x, y0, y1))
+            {
+                dx = x + 1 - r->x0;
+                hits |= HIT_LEFT;
+                break;
+            }
+    }
+    r->x0 += dx;
+    r->x1 += dx;
+
+    int x0 = floor_int(r->x0), count = floor_int(r->x1 - edge) - x0 + 1;
+    if (dy > 0.0f)
+    {
+        for (int y = floor_int(r->y1 - edge) + 1; y <= floor_int(r->y1 + dy - edge); y++)
+            if (tilegrid_any(grid, MASK_SOLID, x0, y, count))
+            {
+                dy = y - r->y1;
+                hits |= HIT_UP;
+                break;
+            }
+    }
+    else if (dy < 0.0f)
+    {
+        for (int y = floor_int(r->y0) - 1; y >= floor_int(r->y0 + dy); y--)
+            if (tilegrid_any(grid, MASK_SOLID, x0, y, count))
+            {
+                dy = y + 1 - r->y0;
+                hits |= HIT_DOWN;
+                break;
+            }
+    }
+    r->y0 += dy;
+    r->y1 += dy;
+    return hits;
+}
+
+static void step_float(const struct TileGrid *grid, struct FloatRunner *runners)
+{
+    const float speed = fixed_to_float(RUN_SPEED), gravity = fixed_to_float(GRAVITY);
+    const float max_fall = fixed_to_float(MAX_FALL), jump = fixed_to_float(JUMP);
+
+    for (int i = 0; i < RUNNERS; i++)
+    {
+        struct FloatRunner *r = runners + i;
+        r->vx = cosf(r->angle) * speed;
+        r->vy = r->vy - gravity < -max_fall ? -max_fall : r->vy - gravity;
+
+        int hits = move_float(grid, r, r->vx, r->vy);
+        if (hits & (HIT_LEFT | HIT_RIGHT))
+            r->angle += 150.0f * 3.14159265f / 180.0f;
+        if (hits & HIT_DOWN)
+            r->vy = jump * fabsf(sinf(r->angle));
+        if (hits & HIT_UP)
+            r->vy = 0.0f;
+    }
+}
+
+int main()
+{
+    struct TileGrid grid;
+    build_level(&grid);
+
+    static struct FixedRunner fixed_runners[RUNNERS];
+    static struct FloatRunner float_runners[RUNNERS];
+    for (int i = 0; i < RUNNERS; i++)
+    {
+        fixed x = fixed_from_int(1 + i % (LEVEL_W - 3)), y = fixed_from_int(1 + (i / (LEVEL_W - 3)) * 4);
+        unsigned int angle = next_random() & (FIXED_TURN - 1);
+        fixed_runners[i] = (struct FixedRunner){fixed_aabb(x, y, RUNNER_W, RUNNER_H), {0, 0}, angle};
+        float_runners[i] = (struct FloatRunner){fixed_to_float(x), fixed_to_float(y), fixed_to_float(x + RUNNER_W),
+                                                fixed_to_float(y + RUNNER_H), 0.0f, 0.0f, angle * (2.0f * 3.14159265f / FIXED_TURN)};
+    }
+
+    double start = now_seconds();
+    for (int s = 0; s < STEPS; s++)
+        step_fixed(&grid, fixed_runners);
+    double fixed_time = now_seconds() - start;
+
+    start = now_seconds();
+    for (int s = 0; s < STEPS; s++)
+        step_float(&grid, float_runners);
+    double float_time = now_seconds() - start;
+
+    // fnv-1a over every position and velocity
+    unsigned int checksum = 2166136261u;
+    for (int i = 0; i < RUNNERS; i++)
+    {
+        const fixed values[6] = {fixed_runners[i].box.min.x, fixed_runners[i].box.min.y, fixed_runners[i].box.max.x,
+                                 fixed_runners[i].box.max.y, fixed_runners[i].velocity.x, fixed_runners[i].velocity.y};
+        for (int v = 0; v < 6; v++)
+            for (int b = 0; b < 4; b++)
+                checksum = (checksum ^ ((unsigned int)values[v] >> (b * 8) & 0xFF)) * 16777619u;
+    }
+
+    double updates = (double)RUNNERS * STEPS;
+    printf("fixed: %.1f ns per runner update\n", fixed_time * 1e9 / updates);
+    printf("float: %.1f ns per runner update\n", float_time * 1e9 / updates);
+    printf("fixed checksum %08x, %s\n", checksum, checksum == SIM_CHECKSUM ? "matches the host" : "DIFFERS from the host");
+    printf("runner 0 after %d steps: fixed (%.4f, %.4f), float (%.4f, %.4f)\n", STEPS,
+           fixed_to_float(fixed_runners[0].box.min.x), fixed_to_float(fixed_runners[0].box.min.y), float_runners[0].x0, float_runners[0].y0);
+
+    tilegrid_destroy(&grid);
+    return checksum == SIM_CHECKSUM ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+// Host microbenchmark of the packed tile grid against the plain table array
+//
+// build and run from psp_loadrunner/ with your host compiler:
+//     gcc -O2 -o grid_bench tools/grid_bench.c tilegrid.c level.c
+//     ./grid_bench
+//
+// both versions answer the same questions:
+// "is anything solid in the 3 cells below x-1 .. x+1" for every cell, which is what falling checks do
+// "is there any gold left in the level", which is checked every time gold is picked up
+
+#include "../headers/level.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define LEVEL_W (28)
+#define LEVEL_H (17)
+#define ITERATIONS (200000)
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// the table is stored top row first like the old table.c, so the row below y is y + 1
+static int array_solid_below(unsigned int (*table)[LEVEL_W], int x, int y)
+{
+    if (y + 1 >= LEVEL_H)
+        return 0;
+
+    for (int dx = -1; dx <= 1; dx++)
+    {
+        int cx = x + dx;
+        if (cx < 0 || cx >= LEVEL_W)
+            continue;
+
+        unsigned int tile = table[y + 1][cx];
+        if (tile == TILE_BRICK || tile == TILE_CONCRETE)
+            return 1;
+    }
+    return 0;
+}
+
+// the grid is stored bottom row first, so the row below y is y - 1
+static int grid_solid_below(const struct TileGrid *grid, int x, int y)
+{
+    return tilegrid_any(grid, MASK_SOLID, x - 1, y - 1, 3);
+}
+
+static int array_gold_left(unsigned int (*table)[LEVEL_W])
+{
+    for (int y = 0; y < LEVEL_H; y++)
+        for (int x = 0; x < LEVEL_W; x++)
+            if (table[y][x] == TILE_GOLD)
+                return 1;
+    return 0;
+}
+
+static int grid_gold_left(const struct TileGrid *grid)
+{
+    const unsigned int *words = grid->masks[MASK_GOLD];
+    unsigned int any = 0;
+    for (unsigned int i = 0; i < grid->words_per_row * grid->height; i++)
+        any |= words[i];
+    return any != 0;
+}
+
+int main()
+{
+    struct TileGrid grid;
+    if (level_load("levels/level01.lvl", &grid) < 0 || grid.width != LEVEL_W || grid.height != LEVEL_H)
+    {
+        printf("run from psp_loadrunner/ so levels/level01.lvl can be found\n");
+        return 1;
+    }
+
+    static unsigned int table[LEVEL_H][LEVEL_W];
+    for (int y = 0; y < LEVEL_H; y++)
+        for (int x = 0; x < LEVEL_W; x++)
+            table[y][x] = tilegrid_get(&grid, x, LEVEL_H - 1 - y);
+
+    // both versions have to agree on every cell before timing means anything
+    for (int y = 0; y < LEVEL_H; y++)
+    {
+        for (int x = 0; x < LEVEL_W; x++)
+        {
+            if (array_solid_below(table, x, y) != grid_solid_below(&grid, x, LEVEL_H - 1 - y))
+            {
+                printf("mismatch at %d,%d\n", x, y);
+                return 1;
+            }
+        }
+    }
+
+    volatile unsigned int sink = 0;
+    unsigned int hits = 0;
+
+    double start = now_seconds();
+    for (int i = 0; i < ITERATIONS; i++)
+        for (int y = 0; y < LEVEL_H; y++)
+            for (int x = 0; x < LEVEL_W; x++)
+                hits += array_solid_below(table, x, y);
+    double array_time = now_seconds() - start;
+    sink += hits;
+
+    hits = 0;
+    start = now_seconds();
+    for (int i = 0; i < ITERATIONS; i++)
+        for (int y = 0; y < LEVEL_H; y++)
+            for (int x = 0; x < LEVEL_W; x++)
+                hits += grid_solid_below(&grid, x, y);
+    double grid_time = now_seconds() - start;
+    sink += hits;
+
+    // the level has gold near the end of the table, so the array has to walk most of it
+    table[1][4] = table[12][7] = table[12][24] = table[6][22] = table[3][23] = TILE_EMPTY;
+    tilegrid_set(&grid, 4, LEVEL_H - 1 - 1, TILE_EMPTY);
+    tilegrid_set(&grid, 7, LEVEL_H - 1 - 12, TILE_EMPTY);
+    tilegrid_set(&grid, 24, LEVEL_H - 1 - 12, TILE_EMPTY);
+    tilegrid_set(&grid, 22, LEVEL_H - 1 - 6, TILE_EMPTY);
+    tilegrid_set(&grid, 23, LEVEL_H - 1 - 3, TILE_EMPTY);
+    if (array_gold_left(table) != grid_gold_left(&grid))
+    {
+        printf("gold mismatch\n");
+        return 1;
+    }
+
+    hits = 0;
+    start = now_seconds();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        hits += array_gold_left(table);
+        table[14][18] = (i & 1) ? TILE_GOLD : TILE_EMPTY; // keeps the compiler from hoisting the scan
+    }
+    double array_gold_time = now_seconds() - start;
+    sink += hits;
+
+    hits = 0;
+    start = now_seconds();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        hits += grid_gold_left(&grid);
+        tilegrid_set(&grid, 18, LEVEL_H - 1 - 14, (i & 1) ? TILE_GOLD : TILE_EMPTY);
+    }
+    double grid_gold_time = now_seconds() - start;
+    sink += hits;
+
+    double queries = (double)ITERATIONS * LEVEL_W * LEVEL_H;
+    printf("solid below 3 cells\n");
+    printf("unsigned int table[17][28]: %8.2f ns/query, %u bytes\n", array_time / queries * 1e9,
+           (unsigned int)(LEVEL_W * LEVEL_H * sizeof(unsigned int)));
+    printf("packed grid + bitboards:    %8.2f ns/query, %u bytes\n", grid_time / queries * 1e9,
+           (unsigned int)(LEVEL_W * LEVEL_H + grid.words_per_row * LEVEL_H * MASK_COUNT * sizeof(unsigned int)));
+    printf("speedup: %.2fx\n", array_time / grid_time);
+
+    printf("any gold left\n");
+    printf("unsigned int table[17][28]: %8.2f ns/query\n", array_gold_time / ITERATIONS * 1e9);
+    printf("packed grid + bitboards:    %8.2f ns/query\n", grid_gold_time / ITERATIONS * 1e9);
+    printf("speedup: %.2fx\n", array_gold_time / grid_gold_time);
+
+    tilegrid_destroy(&grid);
+    return 0;
+}
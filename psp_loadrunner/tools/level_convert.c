@@ -0,0 +1,140 @@
+// Host converter from text level layouts to the binary .lvl format read by level_load
+//
+// build from psp_loadrunner/ with your host compiler:
+//     gcc -O2 -o level_convert tools/level_convert.c
+//     ./level_convert levels/level01.txt levels/level01.lvl
+//
+// the text layout is one line per row, top row first, one character per cell.
+// the characters are the ones of the tile table in headers/tiles.h:
+//     .  empty (a space works too)
+//     #  brick
+//     @  concrete
+//     H  ladder
+//     -  bar
+//     $  gold
+// shorter lines are padded with empty cells
+
+#include "../headers/level.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE (LEVEL_MAX_SIDE + 3)
+
+static int tile_from_char(char c)
+{
+    if (c == ' ')
+        return TILE_EMPTY;
+
+    for (int tile = 0; tile < TILE_TABLE_SIZE; tile++)
+        if (c != '\0' && tile_properties[tile].ch == c)
+            return tile;
+    return -1;
+}
+
+static unsigned int line_length(const char *line)
+{
+    unsigned int len = strlen(line);
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+        len--;
+    return len;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <layout.txt> <level.lvl>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *in = fopen(argv[1], "r");
+    if (!in)
+    {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    // keep every line, the height is only known at the end and rows are written bottom first
+    static char lines[LEVEL_MAX_SIDE][MAX_LINE];
+    char line[MAX_LINE];
+    unsigned int width = 0, height = 0;
+
+    while (fgets(line, MAX_LINE, in))
+    {
+        unsigned int len = line_length(line);
+        if (len == 0)
+            continue; // blank lines, usually the end of the file
+
+        if (len > LEVEL_MAX_SIDE || height == LEVEL_MAX_SIDE)
+        {
+            fprintf(stderr, "%s: level is larger than %d cells\n", argv[1], LEVEL_MAX_SIDE);
+            fclose(in);
+            return 1;
+        }
+
+        memcpy(lines[height], line, len);
+        lines[height][len] = '\0';
+        height++;
+
+        if (len > width)
+            width = len;
+    }
+    fclose(in);
+
+    if (width == 0 || height == 0)
+    {
+        fprintf(stderr, "%s: empty level\n", argv[1]);
+        return 1;
+    }
+
+    unsigned char *cells = (unsigned char *)malloc(width * height);
+    for (unsigned int row = 0; row < height; row++)
+    {
+        const char *text = lines[row];
+        unsigned int len = strlen(text);
+        unsigned char *dest = cells + (height - 1 - row) * width;
+
+        for (unsigned int x = 0; x < width; x++)
+        {
+            int tile = x < len ? tile_from_char(text[x]) : TILE_EMPTY;
+            if (tile < 0)
+            {
+                fprintf(stderr, "%s:%u:%u: unknown tile '%c'\n", argv[1], row + 1, x + 1, text[x]);
+                free(cells);
+                return 1;
+            }
+            dest[x] = tile;
+        }
+    }
+
+    struct LevelHeader header;
+    memcpy(header.magic, LEVEL_MAGIC, 4);
+    header.version = LEVEL_VERSION;
+    header.header_size = sizeof(header);
+    header.width = width;
+    header.height = height;
+    header.cell_count = width * height;
+
+    FILE *out = fopen(argv[2], "wb");
+    if (!out)
+    {
+        fprintf(stderr, "cannot create %s\n", argv[2]);
+        free(cells);
+        return 1;
+    }
+
+    int ok = fwrite(&header, sizeof(header), 1, out) == 1 && fwrite(cells, width * height, 1, out) == 1;
+    ok = (fclose(out) == 0) && ok;
+    free(cells);
+
+    if (!ok)
+    {
+        fprintf(stderr, "failed to write %s\n", argv[2]);
+        return 1;
+    }
+
+    printf("%s: %ux%u, %u bytes\n", argv[2], width, height, (unsigned int)(sizeof(header) + width * height));
+    return 0;
+}
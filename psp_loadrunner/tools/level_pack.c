@@ -0,0 +1,129 @@
+// Host tool that packs .lvl files into one compressed .lrp level pack
+//
+// build from psp_loadrunner/ with your host compiler:
+//     gcc -O2 -o level_pack tools/level_pack.c tilegrid.c level.c
+//     ./level_pack levels/levels.lrp levels/level01.lvl levels/level02.lvl
+//
+// levels are stored in the order given, the first one is level 0 of the pack
+
+#include "../headers/level.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// run length encodes cells, see PACK_MAX_RUN. returns the encoded size or -1 for tiles that do not fit a nibble
+static int rle_encode(unsigned char *dest, const unsigned char *cells, unsigned int count)
+{
+    unsigned int size = 0;
+
+    for (unsigned int i = 0; i < count;)
+    {
+        unsigned char tile = cells[i];
+        if (tile > 0x0F)
+            return -1;
+
+        unsigned int run = 1;
+        while (i + run < count && run < PACK_MAX_RUN && cells[i + run] == tile)
+            run++;
+
+        dest[size++] = ((run - 1) << 4) | tile;
+        i += run;
+    }
+
+    return size;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <pack.lrp> <level.lvl>...\n", argv[0]);
+        return 1;
+    }
+
+    unsigned int level_count = argc - 2;
+    struct PackEntry *index = (struct PackEntry *)calloc(level_count, sizeof(struct PackEntry));
+
+    FILE *out = fopen(argv[1], "wb");
+    if (!out || !index)
+    {
+        fprintf(stderr, "cannot create %s\n", argv[1]);
+        return 1;
+    }
+
+    // the header is written again at the end once the index offset is known
+    struct PackHeader header;
+    memset(&header, 0, sizeof(header));
+    fwrite(&header, sizeof(header), 1, out);
+
+    unsigned int offset = sizeof(header);
+    unsigned int total_cells = 0;
+
+    for (unsigned int i = 0; i < level_count; i++)
+    {
+        const char *path = argv[i + 2];
+
+        struct TileGrid grid;
+        if (level_load(path, &grid) < 0)
+        {
+            fprintf(stderr, "cannot load %s\n", path);
+            return 1;
+        }
+
+        unsigned int cell_count = grid.width * grid.height;
+        unsigned char *packed = (unsigned char *)malloc(cell_count);
+        int packed_size = rle_encode(packed, grid.cells, cell_count);
+        if (packed_size < 0)
+        {
+            fprintf(stderr, "%s: tile values above 15 cannot be packed\n", path);
+            return 1;
+        }
+
+        // make sure the runtime decoder gets the level back, in place like on the PSP
+        unsigned char *check = (unsigned char *)malloc(cell_count);
+        memcpy(check + cell_count - packed_size, packed, packed_size);
+        if (level_rle_decode(check, cell_count, check + cell_count - packed_size, packed_size) < 0 ||
+            memcmp(check, grid.cells, cell_count) != 0)
+        {
+            fprintf(stderr, "%s: in place decode check failed\n", path);
+            return 1;
+        }
+        free(check);
+
+        fwrite(packed, packed_size, 1, out);
+
+        index[i].offset = offset;
+        index[i].packed_size = packed_size;
+        index[i].width = grid.width;
+        index[i].height = grid.height;
+
+        printf("%3u %s: %ux%u, %u -> %d bytes\n", i, path, grid.width, grid.height, cell_count, packed_size);
+
+        offset += packed_size;
+        total_cells += cell_count;
+        free(packed);
+        tilegrid_destroy(&grid);
+    }
+
+    fwrite(index, sizeof(struct PackEntry), level_count, out);
+
+    memcpy(header.magic, PACK_MAGIC, 4);
+    header.version = PACK_VERSION;
+    header.header_size = sizeof(header);
+    header.level_count = level_count;
+    header.index_offset = offset;
+    fseek(out, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, out);
+
+    if (fclose(out) != 0)
+    {
+        fprintf(stderr, "failed to write %s\n", argv[1]);
+        return 1;
+    }
+
+    unsigned int file_size = offset + level_count * sizeof(struct PackEntry);
+    printf("%s: %u levels, %u bytes (%u bytes of uncompressed cells)\n", argv[1], level_count, file_size, total_cells);
+    free(index);
+    return 0;
+}
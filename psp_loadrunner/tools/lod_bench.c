@@ -0,0 +1,102 @@
+// Per frame vertex counts of a scene with and without levels of detail (mesh_lod_select in mesh.h)
+//
+// build from psp_loadrunner/ with your host compiler, and convert a model with levels first:
+//     gcc -O2 -o lod_bench tools/lod_bench.c mesh.c -lm
+//     gcc -O2 -o mesh_convert tools/mesh_convert.c mesh.c strip.c -lm
+//     ./mesh_convert model.obj model.mesh --lod 4
+//     ./lod_bench model.mesh
+//
+// a row of copies of the model goes from the camera to far away under a 60 degree perspective on the
+// 480x272 screen, every level allowed 2 pixels of error. the camera walks down the row and back with a small bob, like a player would. it
+// prints the vertices the GE would fetch per frame with level 0 only and with the selected levels,
+// and how often objects changed level with and without the hysteresis of mesh_lod_select (changes
+// back and forth are what shows as popping)
+
+#include "../headers/mesh.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define OBJECTS (64)
+#define SPACING (3.0f)  // model units between two copies
+#define FRAMES (1200)   // down the row and back
+#define BOB (0.5f)      // camera sway while walking, in model units, enough to go back and forth a little
+#define SCREEN_HEIGHT (272.0f)
+#define FOVY (60.0f)
+#define MAX_ERROR_PIXELS (2.0f)
+
+// what mesh_lod_select does without remembering the level: the coarsest one that is good enough
+static unsigned int select_stateless(const struct MeshLod *lod, float pixels_per_unit)
+{
+    unsigned int level = 0;
+    while (level + 1 < lod->count && lod->levels[level + 1].header->lod_error * pixels_per_unit <= lod->max_error_pixels)
+        level++;
+    return level;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s <model.mesh>\n", argv[0]);
+        return 1;
+    }
+
+    struct MeshLod lod;
+    if (mesh_lod_load(argv[1], &lod) < 0)
+    {
+        fprintf(stderr, "cannot load %s\n", argv[1]);
+        return 1;
+    }
+
+    // one copy of the chain per object, each keeps its own level
+    lod.max_error_pixels = MAX_ERROR_PIXELS;
+    static struct MeshLod objects[OBJECTS];
+    static unsigned int stateless[OBJECTS];
+    for (int i = 0; i < OBJECTS; i++)
+        objects[i] = lod;
+
+    float half_height = SCREEN_HEIGHT / 2.0f / tanf(FOVY / 2.0f * 3.14159265f / 180.0f);
+    unsigned long long full = 0, selected = 0;
+    unsigned int switches = 0, switches_stateless = 0; // the first frame picks the levels, only the changes after it count
+    unsigned int per_level[MESH_MAX_LODS] = {0};
+
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        float walk = frame < FRAMES / 2 ? (float)frame / (FRAMES / 2) : (float)(FRAMES - frame) / (FRAMES / 2);
+        float camera = walk * OBJECTS * SPACING * 0.5f + BOB * sinf(frame * 0.7f);
+
+        for (int i = 0; i < OBJECTS; i++)
+        {
+            // objects behind the camera are left out of both counts
+            float distance = (i + 1) * SPACING - camera;
+            if (distance < 0.1f)
+                continue;
+
+            float pixels_per_unit = half_height / distance;
+            unsigned int before = objects[i].current;
+            unsigned int level = mesh_lod_select(&objects[i], pixels_per_unit);
+            switches += frame > 0 && level != before;
+
+            unsigned int level_stateless = select_stateless(&lod, pixels_per_unit);
+            switches_stateless += frame > 0 && level_stateless != stateless[i];
+            stateless[i] = level_stateless;
+
+            full += lod.levels[0].header->index_count;
+            selected += lod.levels[level].header->index_count;
+            per_level[level]++;
+        }
+    }
+
+    printf("%s: %u levels, loaded in %u us\n", argv[1], lod.count, lod.levels[0].load_us);
+    for (unsigned int i = 0; i < lod.count; i++)
+        printf("    lod %u: %5u indices, error %g, drawn %u times\n", i, lod.levels[i].header->index_count,
+               lod.levels[i].header->lod_error, per_level[i]);
+    printf("vertices per frame: %llu without lod, %llu with lod (%.1f%%)\n", full / FRAMES, selected / FRAMES,
+           full ? 100.0 * selected / full : 0.0);
+    printf("level changes: %u with hysteresis, %u without\n", switches, switches_stateless);
+
+    mesh_lod_destroy(&lod);
+    return 0;
+}
@@ -0,0 +1,1346 @@
+// Host converter from Wavefront .obj and glTF 2.0 (.gltf / .glb) to the GE ready .mesh format read by mesh_load
+//
+// build from psp_loadrunner/ with your host compiler:
+//     gcc -O2 -o mesh_convert tools/mesh_convert.c mesh.c strip.c -lm
+//     ./mesh_convert model.obj model.mesh [options]
+//
+// options, the defaults keep what the model has at the smallest size the GE reads:
+//     --texture none|8|16|float       texture coordinates (16 when the model has them)
+//     --color none|5650|5551|4444|8888 vertex colors (8888 when the model has them)
+//     --normal none|8|16|float        normals (none, the game has no lighting)
+//     --position 8|16|float           positions (16)
+//     --list                          keep the triangle list instead of a strip
+//     --lod n                         levels of detail in the file (1, no simplified levels)
+//
+// .obj: v (with an optional r g b after x y z), vt, vn and f lines, faces of any size are cut into fans.
+// .gltf / .glb: the first primitive of the first mesh, node transforms are not applied, buffers can be
+// next to the file, embedded as base64 or in the .glb binary chunk.
+//
+// 8 and 16 bit positions are quantized to the bounding box of the mesh and texture coordinates to their
+// range, the header keeps the scale and offset that undo it. vertices are stored in the order the
+// indices first use them. every level also gets the 8 corners of its bounding box, which mesh_draw
+// hands to the GE bounding box test.
+//
+// --lod n writes a chain of up to n levels of detail in the file, level 0 the model and every next
+// one with at most half the triangles of the one before, simplified by vertex clustering. each level
+// keeps how far its vertices moved (lod_error), what mesh_lod_select compares to the pixel size.
+// the file is loaded back with mesh_lod_load and the sizes, errors and load time of every level are printed
+
+#include "../headers/mesh.h"
+#include "../headers/strip.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the GE indexes with 16 bits
+#define MAX_VERTICES (65536)
+
+struct Source
+{
+    unsigned int vertex_count;
+    unsigned int index_count; // 3 per triangle
+    float *position;          // 3 per vertex
+    float *uv;                // 2 per vertex, or NULL
+    float *color;             // r g b a (0 .. 1) per vertex, or NULL
+    float *normal;            // 3 per vertex, or NULL
+    unsigned int *indices;
+};
+
+static void *grow(void *array, unsigned int *capacity, unsigned int needed, unsigned int element)
+{
+    if (needed <= *capacity)
+        return array;
+
+    unsigned int bigger = *capacity ? *capacity * 2 : 256;
+    while (bigger < needed)
+        bigger *= 2;
+    void *grown = realloc(array, (size_t)bigger * element);
+    if (grown == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    *capacity = bigger;
+    return grown;
+}
+
+static unsigned char *read_file(const char *path, unsigned int *size)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        return NULL;
+
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    // one more byte, text files are parsed as C strings
+    unsigned char *data = (unsigned char *)malloc(length + 1);
+    if (data == NULL || fread(data, 1, length, f) != (size_t)length)
+    {
+        free(data);
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+
+    data[length] = '\0';
+    *size = (unsigned int)length;
+    return data;
+}
+
+// ---- obj
+
+// one corner of a face, the position / texture / normal numbers it uses (-1 when missing)
+struct Corner
+{
+    int p, t, n;
+};
+
+static unsigned int corner_hash(struct Corner c)
+{
+    return ((unsigned int)c.p * 73856093u) ^ ((unsigned int)c.t * 19349663u) ^ ((unsigned int)c.n * 83492791u);
+}
+
+// resolves an obj index (1 based, negative counts back from the last one), -1 when out of range
+static int obj_index(int number, unsigned int count)
+{
+    int index = number < 0 ? (int)count + number : number - 1;
+    return index >= 0 && index < (int)count ? index : -1;
+}
+
+static int load_obj(const char *path, struct Source *source)
+{
+    unsigned int size;
+    char *text = (char *)read_file(path, &size);
+    if (text == NULL)
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        return -1;
+    }
+
+    float *positions = NULL, *colors = NULL, *uvs = NULL, *normals = NULL;
+    unsigned int position_count = 0, uv_count = 0, normal_count = 0;
+    unsigned int position_capacity = 0, color_capacity = 0, uv_capacity = 0, normal_capacity = 0;
+    int has_color = 0, has_uv = 0, has_normal = 0;
+
+    // the distinct corners become the vertices, found again through an open addressing table
+    struct Corner *corners = NULL;
+    unsigned int corner_count = 0, corner_capacity = 0;
+    unsigned int table_size = 1024;
+    int *table = (int *)malloc(table_size * sizeof(int));
+    memset(table, -1, table_size * sizeof(int));
+
+    unsigned int *indices = NULL;
+    unsigned int index_count = 0, index_capacity = 0;
+
+    unsigned int line_number = 0;
+    for (char *line = strtok(text, "\n"); line != NULL; line = strtok(NULL, "\n"))
+    {
+        line_number++;
+        char *p = line;
+        while (*p == ' ' || *p == '\t')
+            p++;
+
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            float v[6] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+            int read = sscanf(p + 2, "%f %f %f %f %f %f", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]);
+            positions = (float *)grow(positions, &position_capacity, position_count + 1, 3 * sizeof(float));
+            colors = (float *)grow(colors, &color_capacity, position_count + 1, 3 * sizeof(float));
+            memcpy(positions + position_count * 3, v, 3 * sizeof(float));
+            memcpy(colors + position_count * 3, v + 3, 3 * sizeof(float));
+            position_count++;
+            has_color |= read == 6;
+        }
+        else if (p[0] == 'v' && p[1] == 't')
+        {
+            float v[2] = {0.0f, 0.0f};
+            sscanf(p + 2, "%f %f", &v[0], &v[1]);
+            uvs = (float *)grow(uvs, &uv_capacity, uv_count + 1, 2 * sizeof(float));
+            uvs[uv_count * 2 + 0] = v[0];
+            uvs[uv_count * 2 + 1] = 1.0f - v[1]; // obj has v going up, the GE down
+            uv_count++;
+        }
+        else if (p[0] == 'v' && p[1] == 'n')
+        {
+            float v[3] = {0.0f, 0.0f, 1.0f};
+            sscanf(p + 2, "%f %f %f", &v[0], &v[1], &v[2]);
+            normals = (float *)grow(normals, &normal_capacity, normal_count + 1, 3 * sizeof(float));
+            memcpy(normals + normal_count * 3, v, 3 * sizeof(float));
+            normal_count++;
+        }
+        else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            unsigned int face[64];
+            unsigned int face_size = 0;
+
+            for (char *word = p + 2; *word;)
+            {
+                while (*word == ' ' || *word == '\t' || *word == '\r')
+                    word++;
+                if (*word == '\0')
+                    break;
+
+                // p, p/t, p//n or p/t/n
+                struct Corner c = {0, 0, 0};
+                char *end;
+                c.p = obj_index((int)strtol(word, &end, 10), position_count);
+                c.t = c.n = -1;
+                if (*end == '/')
+                {
+                    if (end[1] != '/')
+                        c.t = obj_index((int)strtol(end + 1, &end, 10), uv_count);
+                    else
+                        end++;
+                    if (*end == '/')
+                        c.n = obj_index((int)strtol(end + 1, &end, 10), normal_count);
+                }
+                word = end;
+
+                if (c.p < 0 || face_size == sizeof(face) / sizeof(face[0]))
+                {
+                    fprintf(stderr, "%s:%u: bad face\n", path, line_number);
+                    return -1;
+                }
+                has_uv |= c.t >= 0;
+                has_normal |= c.n >= 0;
+
+                // find the corner or add it
+                unsigned int slot = corner_hash(c) & (table_size - 1);
+                while (table[slot] >= 0 && memcmp(&corners[table[slot]], &c, sizeof(c)) != 0)
+                    slot = (slot + 1) & (table_size - 1);
+                int vertex = table[slot];
+                if (vertex < 0)
+                {
+                    corners = (struct Corner *)grow(corners, &corner_capacity, corner_count + 1, sizeof(struct Corner));
+                    corners[corner_count] = c;
+                    vertex = table[slot] = corner_count++;
+
+                    // keep the table at most half full
+                    if (corner_count * 2 > table_size)
+                    {
+                        table_size *= 2;
+                        table = (int *)realloc(table, table_size * sizeof(int));
+                        memset(table, -1, table_size * sizeof(int));
+                        for (unsigned int i = 0; i < corner_count; i++)
+                        {
+                            unsigned int s = corner_hash(corners[i]) & (table_size - 1);
+                            while (table[s] >= 0)
+                                s = (s + 1) & (table_size - 1);
+                            table[s] = i;
+                        }
+                    }
+                }
+                face[face_size++] = vertex;
+            }
+
+            // a fan around the first corner
+            for (unsigned int i = 2; i < face_size; i++)
+            {
+                indices = (unsigned int *)grow(indices, &index_capacity, index_count + 3, sizeof(unsigned int));
+                indices[index_count++] = face[0];
+                indices[index_count++] = face[i - 1];
+                indices[index_count++] = face[i];
+            }
+        }
+    }
+
+    // the vertices, what the corners point at
+    source->vertex_count = corner_count;
+    source->index_count = index_count;
+    source->indices = indices;
+    source->position = (float *)malloc((size_t)corner_count * 3 * sizeof(float));
+    source->color = has_color ? (float *)malloc((size_t)corner_count * 4 * sizeof(float)) : NULL;
+    source->uv = has_uv ? (float *)malloc((size_t)corner_count * 2 * sizeof(float)) : NULL;
+    source->normal = has_normal ? (float *)malloc((size_t)corner_count * 3 * sizeof(float)) : NULL;
+
+    for (unsigned int i = 0; i < corner_count; i++)
+    {
+        struct Corner c = corners[i];
+        memcpy(source->position + i * 3, positions + c.p * 3, 3 * sizeof(float));
+        if (has_color)
+        {
+            memcpy(source->color + i * 4, colors + c.p * 3, 3 * sizeof(float));
+            source->color[i * 4 + 3] = 1.0f;
+        }
+        if (has_uv)
+        {
+            source->uv[i * 2 + 0] = c.t >= 0 ? uvs[c.t * 2 + 0] : 0.0f;
+            source->uv[i * 2 + 1] = c.t >= 0 ? uvs[c.t * 2 + 1] : 0.0f;
+        }
+        if (has_normal)
+        {
+            static const float up[3] = {0.0f, 0.0f, 1.0f};
+            memcpy(source->normal + i * 3, c.n >= 0 ? normals + c.n * 3 : up, 3 * sizeof(float));
+        }
+    }
+
+    free(positions);
+    free(colors);
+    free(uvs);
+    free(normals);
+    free(corners);
+    free(table);
+    free(text);
+    return 0;
+}
+
+// ---- json, just what glTF needs
+
+enum JsonType
+{
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT,
+};
+
+struct Json
+{
+    enum JsonType type;
+    double number;
+    char *string;
+    unsigned int count;    // array or object entries
+    struct Json *children; // count values
+    char **keys;           // count keys of an object
+};
+
+static const char *skip_space(const char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+        p++;
+    return p;
+}
+
+// returns the text after the string, or NULL. escapes other than the simple ones become '?'
+static const char *json_string(const char *p, char **out)
+{
+    if (*p != '"')
+        return NULL;
+    p++;
+
+    const char *end = p;
+    while (*end && *end != '"')
+        end += end[0] == '\\' && end[1] ? 2 : 1;
+    if (*end != '"')
+        return NULL;
+
+    char *s = (char *)malloc(end - p + 1);
+    char *o = s;
+    while (p < end)
+    {
+        if (*p != '\\')
+        {
+            *o++ = *p++;
+            continue;
+        }
+        char e = p[1];
+        p += 2;
+        *o++ = e == 'n' ? '\n' : e == 't' ? '\t' : e == '"' || e == '\\' || e == '/' ? e : '?';
+        if (e == 'u')
+            p += 4 <= end - p ? 4 : end - p;
+    }
+    *o = '\0';
+    *out = s;
+    return end + 1;
+}
+
+static const char *json_parse(const char *p, struct Json *out)
+{
+    memset(out, 0, sizeof(*out));
+    p = skip_space(p);
+
+    if (*p == '{' || *p == '[')
+    {
+        int object = *p == '{';
+        char close = object ? '}' : ']';
+        unsigned int capacity = 0, key_capacity = 0;
+        out->type = object ? JSON_OBJECT : JSON_ARRAY;
+
+        p = skip_space(p + 1);
+        if (*p == close)
+            return p + 1;
+
+        for (;;)
+        {
+            if (object)
+            {
+                out->keys = (char **)grow(out->keys, &key_capacity, out->count + 1, sizeof(char *));
+                p = json_string(skip_space(p), &out->keys[out->count]);
+                if (p == NULL || *(p = skip_space(p)) != ':')
+                    return NULL;
+                p++;
+            }
+            out->children = (struct Json *)grow(out->children, &capacity, out->count + 1, sizeof(struct Json));
+            p = json_parse(p, &out->children[out->count]);
+            if (p == NULL)
+                return NULL;
+            out->count++;
+
+            p = skip_space(p);
+            if (*p == close)
+                return p + 1;
+            if (*p != ',')
+                return NULL;
+            p++;
+        }
+    }
+    if (*p == '"')
+    {
+        out->type = JSON_STRING;
+        return json_string(p, &out->string);
+    }
+    if (strncmp(p, "true", 4) == 0 || strncmp(p, "false", 5) == 0)
+    {
+        out->type = JSON_BOOL;
+        out->number = *p == 't';
+        return p + (*p == 't' ? 4 : 5);
+    }
+    if (strncmp(p, "null", 4) == 0)
+        return p + 4;
+
+    char *end;
+    out->number = strtod(p, &end);
+    out->type = JSON_NUMBER;
+    return end == p ? NULL : end;
+}
+
+static const struct Json *json_get(const struct Json *object, const char *key)
+{
+    if (object == NULL || object->type != JSON_OBJECT)
+        return NULL;
+    for (unsigned int i = 0; i < object->count; i++)
+        if (strcmp(object->keys[i], key) == 0)
+            return &object->children[i];
+    return NULL;
+}
+
+static const struct Json *json_at(const struct Json *array, unsigned int i)
+{
+    return array != NULL && array->type == JSON_ARRAY && i < array->count ? &array->children[i] : NULL;
+}
+
+static double json_number(const struct Json *value, double fallback)
+{
+    return value != NULL && (value->type == JSON_NUMBER || value->type == JSON_BOOL) ? value->number : fallback;
+}
+
+// ---- gltf
+
+struct Gltf
+{
+    struct Json root;
+    unsigned int buffer_count;
+    unsigned char **buffers;
+    unsigned int *buffer_sizes;
+};
+
+static int base64_value(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    return c == '+' ? 62 : c == '/' ? 63 : -1;
+}
+
+static unsigned char *base64_decode(const char *text, unsigned int *size)
+{
+    unsigned int length = strlen(text);
+    unsigned char *out = (unsigned char *)malloc(length / 4 * 3 + 3);
+    unsigned int bits = 0, count = 0, written = 0;
+
+    for (unsigned int i = 0; i < length; i++)
+    {
+        int value = base64_value(text[i]);
+        if (value < 0)
+            continue;
+        bits = bits << 6 | value;
+        count += 6;
+        if (count >= 8)
+        {
+            count -= 8;
+            out[written++] = (bits >> count) & 0xFF;
+        }
+    }
+    *size = written;
+    return out;
+}
+
+// the buffers of the file: next to it, embedded as base64, or the binary chunk of a .glb
+static int load_buffers(struct Gltf *gltf, const char *path, unsigned char *glb_chunk, unsigned int glb_size)
+{
+    const struct Json *buffers = json_get(&gltf->root, "buffers");
+    gltf->buffer_count = buffers ? buffers->count : 0;
+    gltf->buffers = (unsigned char **)calloc(gltf->buffer_count + 1, sizeof(unsigned char *));
+    gltf->buffer_sizes = (unsigned int *)calloc(gltf->buffer_count + 1, sizeof(unsigned int));
+
+    for (unsigned int i = 0; i < gltf->buffer_count; i++)
+    {
+        const struct Json *uri = json_get(json_at(buffers, i), "uri");
+        if (uri == NULL || uri->type != JSON_STRING)
+        {
+            gltf->buffers[i] = glb_chunk;
+            gltf->buffer_sizes[i] = glb_size;
+        }
+        else if (strncmp(uri->string, "data:", 5) == 0)
+        {
+            const char *comma = strchr(uri->string, ',');
+            if (comma == NULL)
+                return -1;
+            gltf->buffers[i] = base64_decode(comma + 1, &gltf->buffer_sizes[i]);
+        }
+        else
+        {
+            // relative to the directory of the .gltf
+            const char *slash = strrchr(path, '/');
+            unsigned int directory = slash ? (unsigned int)(slash - path + 1) : 0;
+            char *file = (char *)malloc(directory + strlen(uri->string) + 1);
+            memcpy(file, path, directory);
+            strcpy(file + directory, uri->string);
+            gltf->buffers[i] = read_file(file, &gltf->buffer_sizes[i]);
+            if (gltf->buffers[i] == NULL)
+            {
+                fprintf(stderr, "cannot open %s\n", file);
+                return -1;
+            }
+            free(file);
+        }
+        if (gltf->buffers[i] == NULL)
+            return -1;
+    }
+    return 0;
+}
+
+static unsigned int component_size(int type)
+{
+    switch (type)
+    {
+    case 5120: // byte
+    case 5121: // unsigned byte
+        return 1;
+    case 5122: // short
+    case 5123: // unsigned short
+        return 2;
+    case 5125: // unsigned int
+    case 5126: // float
+        return 4;
+    }
+    return 0;
+}
+
+static unsigned int type_components(const struct Json *type)
+{
+    if (type == NULL || type->type != JSON_STRING)
+        return 0;
+    if (strcmp(type->string, "SCALAR") == 0)
+        return 1;
+    if (strncmp(type->string, "VEC", 3) == 0)
+        return type->string[3] - '0';
+    return 0;
+}
+
+// reads accessor `index` as floats, components per element (normalized integers become 0 .. 1 or -1 .. 1).
+// elements with fewer components keep the values already in out. returns the element count or -1
+static int read_accessor(const struct Gltf *gltf, int index, unsigned int components, float *out, unsigned int max_count)
+{
+    const struct Json *accessor = json_at(json_get(&gltf->root, "accessors"), index);
+    if (accessor == NULL || json_get(accessor, "sparse") != NULL)
+        return -1;
+
+    const struct Json *view = json_at(json_get(&gltf->root, "bufferViews"), (unsigned int)json_number(json_get(accessor, "bufferView"), -1));
+    if (view == NULL)
+        return -1;
+
+    unsigned int buffer = (unsigned int)json_number(json_get(view, "buffer"), -1);
+    if (buffer >= gltf->buffer_count)
+        return -1;
+
+    int type = (int)json_number(json_get(accessor, "componentType"), 0);
+    unsigned int size = component_size(type);
+    unsigned int count = (unsigned int)json_number(json_get(accessor, "count"), 0);
+    unsigned int element_components = type_components(json_get(accessor, "type"));
+    int normalized = json_number(json_get(accessor, "normalized"), 0) != 0;
+    unsigned int stride = (unsigned int)json_number(json_get(view, "byteStride"), 0);
+    if (stride == 0)
+        stride = size * element_components;
+
+    unsigned int start = (unsigned int)json_number(json_get(view, "byteOffset"), 0) + (unsigned int)json_number(json_get(accessor, "byteOffset"), 0);
+    if (size == 0 || element_components == 0 || count > max_count)
+        return -1;
+    if (count && (unsigned long long)start + (unsigned long long)(count - 1) * stride + size * element_components > gltf->buffer_sizes[buffer])
+        return -1;
+
+    const unsigned char *data = gltf->buffers[buffer] + start;
+    unsigned int used = element_components < components ? element_components : components;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const unsigned char *element = data + i * stride;
+        for (unsigned int c = 0; c < used; c++)
+        {
+            const unsigned char *value = element + c * size;
+            float f;
+            switch (type)
+            {
+            case 5120:
+                f = *(const signed char *)value;
+                f = normalized ? fmaxf(f / 127.0f, -1.0f) : f;
+                break;
+            case 5121:
+                f = *value;
+                f = normalized ? f / 255.0f : f;
+                break;
+            case 5122:
+            {
+                short s;
+                memcpy(&s, value, 2);
+                f = normalized ? fmaxf(s / 32767.0f, -1.0f) : s;
+                break;
+            }
+            case 5123:
+            {
+                unsigned short s;
+                memcpy(&s, value, 2);
+                f = normalized ? s / 65535.0f : s;
+                break;
+            }
+            case 5125:
+            {
+                unsigned int u;
+                memcpy(&u, value, 4);
+                f = (float)u;
+                break;
+            }
+            default:
+                memcpy(&f, value, 4);
+            }
+            out[i * components + c] = f;
+        }
+    }
+    return (int)count;
+}
+
+static int load_gltf(const char *path, struct Source *source)
+{
+    unsigned int size;
+    unsigned char *file = read_file(path, &size);
+    if (file == NULL)
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        return -1;
+    }
+
+    // a .glb is a 12 byte header, a JSON chunk and an optional binary chunk, each chunk after its length and type
+    const char *json_text = (const char *)file;
+    unsigned char *glb_chunk = NULL;
+    unsigned int glb_size = 0;
+    if (size >= 20 && memcmp(file, "glTF", 4) == 0)
+    {
+        unsigned int json_size;
+        memcpy(&json_size, file + 12, 4);
+        if (json_size > size - 20)
+            return -1;
+
+        char *json_copy = (char *)malloc(json_size + 1);
+        memcpy(json_copy, file + 20, json_size);
+        json_copy[json_size] = '\0';
+        json_text = json_copy;
+
+        unsigned int bin_at = 20 + json_size;
+        if (size >= 8 && bin_at <= size - 8)
+        {
+            memcpy(&glb_size, file + bin_at, 4);
+            glb_chunk = file + bin_at + 8;
+            if (glb_size > size - bin_at - 8)
+                return -1;
+        }
+    }
+
+    struct Gltf gltf;
+    if (json_parse(json_text, &gltf.root) == NULL || load_buffers(&gltf, path, glb_chunk, glb_size) < 0)
+    {
+        fprintf(stderr, "%s: cannot read the glTF\n", path);
+        return -1;
+    }
+
+    const struct Json *primitive = json_at(json_get(json_at(json_get(&gltf.root, "meshes"), 0), "primitives"), 0);
+    const struct Json *attributes = json_get(primitive, "attributes");
+    if (attributes == NULL || json_get(attributes, "POSITION") == NULL)
+    {
+        fprintf(stderr, "%s: no mesh with positions\n", path);
+        return -1;
+    }
+    if (json_number(json_get(primitive, "mode"), 4) != 4)
+    {
+        fprintf(stderr, "%s: only triangle lists are converted\n", path);
+        return -1;
+    }
+
+    int position = (int)json_number(json_get(attributes, "POSITION"), -1);
+    const struct Json *count = json_get(json_at(json_get(&gltf.root, "accessors"), position), "count");
+    unsigned int vertex_count = (unsigned int)json_number(count, 0);
+    if (vertex_count == 0 || vertex_count > MAX_VERTICES)
+    {
+        fprintf(stderr, "%s: %u vertices, the GE indexes at most %u\n", path, vertex_count, MAX_VERTICES);
+        return -1;
+    }
+
+    source->vertex_count = vertex_count;
+    source->position = (float *)calloc(vertex_count * 3, sizeof(float));
+    if (read_accessor(&gltf, position, 3, source->position, vertex_count) != (int)vertex_count)
+        goto bad;
+
+    const struct Json *uv = json_get(attributes, "TEXCOORD_0");
+    if (uv != NULL)
+    {
+        source->uv = (float *)calloc(vertex_count * 2, sizeof(float));
+        if (read_accessor(&gltf, (int)json_number(uv, -1), 2, source->uv, vertex_count) != (int)vertex_count)
+            goto bad;
+    }
+
+    const struct Json *color = json_get(attributes, "COLOR_0");
+    if (color != NULL)
+    {
+        // VEC3 colors keep the alpha of 1
+        source->color = (float *)malloc(vertex_count * 4 * sizeof(float));
+        for (unsigned int i = 0; i < vertex_count * 4; i++)
+            source->color[i] = 1.0f;
+        if (read_accessor(&gltf, (int)json_number(color, -1), 4, source->color, vertex_count) != (int)vertex_count)
+            goto bad;
+    }
+
+    const struct Json *normal = json_get(attributes, "NORMAL");
+    if (normal != NULL)
+    {
+        source->normal = (float *)calloc(vertex_count * 3, sizeof(float));
+        if (read_accessor(&gltf, (int)json_number(normal, -1), 3, source->normal, vertex_count) != (int)vertex_count)
+            goto bad;
+    }
+
+    const struct Json *indices = json_get(primitive, "indices");
+    if (indices != NULL)
+    {
+        int accessor = (int)json_number(indices, -1);
+        unsigned int index_count = (unsigned int)json_number(json_get(json_at(json_get(&gltf.root, "accessors"), accessor), "count"), 0);
+        float *values = (float *)malloc(index_count * sizeof(float) + 1);
+        if (read_accessor(&gltf, accessor, 1, values, index_count) != (int)index_count)
+            goto bad;
+
+        source->index_count = index_count;
+        source->indices = (unsigned int *)malloc(index_count * sizeof(unsigned int) + 1);
+        for (unsigned int i = 0; i < index_count; i++)
+        {
+            source->indices[i] = (unsigned int)values[i];
+            if (source->indices[i] >= vertex_count)
+                goto bad;
+        }
+        free(values);
+    }
+    else
+    {
+        // not indexed, every 3 vertices are a triangle
+        source->index_count = vertex_count;
+        source->indices = (unsigned int *)malloc(vertex_count * sizeof(unsigned int));
+        for (unsigned int i = 0; i < vertex_count; i++)
+            source->indices[i] = i;
+    }
+    source->index_count -= source->index_count % 3;
+    return 0;
+
+bad:
+    fprintf(stderr, "%s: bad accessor\n", path);
+    return -1;
+}
+
+// ---- encoding
+
+struct Options
+{
+    int texture;  // enum MeshComponent
+    int color;    // enum MeshColor
+    int normal;   // enum MeshComponent
+    int position; // enum MeshComponent
+    int strip;
+};
+
+// byte offsets of the components in a vertex, like mesh_vertex_size lays them out
+struct Layout
+{
+    unsigned int texture, color, normal, position, size;
+};
+
+static unsigned int align_to(unsigned int offset, unsigned int to)
+{
+    return to ? (offset + to - 1) / to * to : offset;
+}
+
+static struct Layout layout_of(const struct Options *options)
+{
+    static const unsigned int bytes[4] = {0, 1, 2, 4};
+    unsigned int texture = bytes[options->texture];
+    unsigned int color = options->color == MESH_COLOR_8888 ? 4 : options->color ? 2 : 0;
+    unsigned int normal = bytes[options->normal];
+    unsigned int position = bytes[options->position];
+
+    struct Layout layout;
+    layout.texture = align_to(0, texture);
+    layout.color = align_to(layout.texture + 2 * texture, color);
+    layout.normal = align_to(layout.color + color, normal);
+    layout.position = align_to(layout.normal + 3 * normal, position);
+    layout.size = layout.position + 3 * position;
+    return layout;
+}
+
+// writes one element of a component, value being already scaled and rounded for the integer sizes.
+// signed and unsigned values only differ in how the GE reads the same low bits
+static void put_value(unsigned char *out, int component, float value)
+{
+    if (component == MESH_FLOAT)
+    {
+        memcpy(out, &value, 4);
+        return;
+    }
+
+    unsigned int bits = (unsigned int)(long)value;
+    if (component == MESH_16BIT)
+    {
+        unsigned short s = bits;
+        memcpy(out, &s, 2);
+    }
+    else
+    {
+        *out = bits;
+    }
+}
+
+static unsigned int channel(float value, int bits)
+{
+    unsigned int largest = (1u << bits) - 1;
+    float scaled = value * largest + 0.5f;
+    return scaled < 0.0f ? 0 : scaled > largest ? largest : (unsigned int)scaled;
+}
+
+// r g b a to the GE color formats, red in the low bits
+static unsigned int pack_color(const float *rgba, int format)
+{
+    switch (format)
+    {
+    case MESH_COLOR_5650:
+        return channel(rgba[0], 5) | channel(rgba[1], 6) << 5 | channel(rgba[2], 5) << 11;
+    case MESH_COLOR_5551:
+        return channel(rgba[0], 5) | channel(rgba[1], 5) << 5 | channel(rgba[2], 5) << 10 | channel(rgba[3], 1) << 15;
+    case MESH_COLOR_4444:
+        return channel(rgba[0], 4) | channel(rgba[1], 4) << 4 | channel(rgba[2], 4) << 8 | channel(rgba[3], 4) << 12;
+    }
+    return channel(rgba[0], 8) | channel(rgba[1], 8) << 8 | channel(rgba[2], 8) << 16 | channel(rgba[3], 8) << 24;
+}
+
+// what the GE reads as 1.0 and the largest value a component holds, signed or not
+static float fraction_one(int component)
+{
+    return component == MESH_16BIT ? 32768.0f : component == MESH_8BIT ? 128.0f : 1.0f;
+}
+
+static float largest_signed(int component)
+{
+    return component == MESH_16BIT ? 32767.0f : component == MESH_8BIT ? 127.0f : 1.0f;
+}
+
+static float largest_unsigned(int component)
+{
+    return component == MESH_16BIT ? 65535.0f : component == MESH_8BIT ? 255.0f : 1.0f;
+}
+
+static int parse_component(const char *text, int allow_none)
+{
+    if (allow_none && strcmp(text, "none") == 0)
+        return MESH_NONE;
+    if (strcmp(text, "8") == 0)
+        return MESH_8BIT;
+    if (strcmp(text, "16") == 0)
+        return MESH_16BIT;
+    if (strcmp(text, "float") == 0)
+        return MESH_FLOAT;
+    return -1;
+}
+
+static int parse_color(const char *text)
+{
+    static const char *names[] = {"none", "5650", "5551", "4444", "8888"};
+    static const int formats[] = {MESH_COLOR_NONE, MESH_COLOR_5650, MESH_COLOR_5551, MESH_COLOR_4444, MESH_COLOR_8888};
+    for (int i = 0; i < 5; i++)
+        if (strcmp(text, names[i]) == 0)
+            return formats[i];
+    return -1;
+}
+
+static int ends_with(const char *text, const char *end)
+{
+    unsigned int length = strlen(text), end_length = strlen(end);
+    return length >= end_length && strcmp(text + length - end_length, end) == 0;
+}
+
+// what encode writes about a level
+struct Level
+{
+    unsigned char *blob; // header.file_size bytes
+    unsigned int size;
+    unsigned int vertex_count, index_count, triangles;
+    int prim;
+    float position_error, uv_error, lod_error;
+};
+
+// the triangles of source in the GE layout of options, as one .mesh blob
+static void encode(const struct Source *source, const struct Options *options, float lod_error, struct Level *level)
+{
+    unsigned int vertex_type = MESH_VERTEX_TYPE(options->texture, options->color, options->normal, options->position);
+    struct Layout layout = layout_of(options);
+    unsigned int vertex_size = mesh_vertex_size(vertex_type);
+
+    // the triangles as 16 bit indices, then as one strip when it is shorter
+    unsigned int triangles = source->index_count / 3;
+    unsigned short *list = (unsigned short *)malloc(source->index_count * sizeof(unsigned short));
+    for (unsigned int i = 0; i < source->index_count; i++)
+        list[i] = (unsigned short)source->indices[i];
+
+    unsigned short *indices = list;
+    unsigned int index_count = source->index_count;
+    int prim = MESH_TRIANGLES;
+    if (options->strip)
+    {
+        unsigned short *strip = (unsigned short *)malloc(STRIP_MAX_INDICES(triangles) * sizeof(unsigned short));
+        int length = strip ? strip_build(list, triangles, strip) : -1;
+        if (length >= 3 && (unsigned int)length < index_count)
+        {
+            indices = strip;
+            index_count = length;
+            prim = MESH_STRIP;
+        }
+        else
+        {
+            free(strip);
+        }
+    }
+
+    // vertices in the order the indices first use them, unused ones are dropped
+    int *remap = (int *)malloc(source->vertex_count * sizeof(int));
+    unsigned int *order = (unsigned int *)malloc(source->vertex_count * sizeof(unsigned int));
+    unsigned int vertex_count = 0;
+    memset(remap, -1, source->vertex_count * sizeof(int));
+    for (unsigned int i = 0; i < index_count; i++)
+    {
+        if (remap[indices[i]] < 0)
+        {
+            remap[indices[i]] = vertex_count;
+            order[vertex_count++] = indices[i];
+        }
+        indices[i] = (unsigned short)remap[indices[i]];
+    }
+
+    // quantization ranges: positions around the center of their box, texture coordinates from their smallest value
+    float position_scale[3] = {1.0f, 1.0f, 1.0f}, position_offset[3] = {0.0f, 0.0f, 0.0f};
+    float uv_scale[2] = {1.0f, 1.0f}, uv_offset[2] = {0.0f, 0.0f};
+    float low[3], high[3];
+    for (int a = 0; a < 3; a++)
+    {
+        low[a] = high[a] = source->position[order[0] * 3 + a];
+        for (unsigned int i = 1; i < vertex_count; i++)
+        {
+            float v = source->position[order[i] * 3 + a];
+            low[a] = fminf(low[a], v);
+            high[a] = fmaxf(high[a], v);
+        }
+        if (options->position != MESH_FLOAT)
+        {
+            float half = (high[a] - low[a]) / 2.0f;
+            position_offset[a] = (high[a] + low[a]) / 2.0f;
+            // the largest value maps to the largest stored one, a flat axis keeps a scale of 1
+            position_scale[a] = (half > 0.0f ? half : 1.0f) * fraction_one(options->position) / largest_signed(options->position);
+        }
+    }
+    if (options->texture != MESH_NONE && options->texture != MESH_FLOAT && source->uv)
+    {
+        for (int a = 0; a < 2; a++)
+        {
+            float uv_low = source->uv[order[0] * 2 + a], uv_high = uv_low;
+            for (unsigned int i = 1; i < vertex_count; i++)
+            {
+                uv_low = fminf(uv_low, source->uv[order[i] * 2 + a]);
+                uv_high = fmaxf(uv_high, source->uv[order[i] * 2 + a]);
+            }
+            // 0 .. 1 is stored as is, other ranges are moved and squeezed into it
+            if (uv_low < 0.0f || uv_high > 1.0f)
+            {
+                uv_offset[a] = uv_low;
+                uv_scale[a] = uv_high > uv_low ? uv_high - uv_low : 1.0f;
+            }
+        }
+    }
+
+    // the bounding sphere around the model origin
+    float radius = 0.0f;
+    for (unsigned int i = 0; i < vertex_count; i++)
+    {
+        const float *p = source->position + order[i] * 3;
+        radius = fmaxf(radius, sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]));
+    }
+
+    // header, vertices and indices, each block 16 byte aligned
+    struct MeshHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MESH_MAGIC, 4);
+    header.version = MESH_VERSION;
+    header.header_size = sizeof(header);
+    header.vertex_type = vertex_type;
+    header.vertex_size = vertex_size;
+    header.prim = prim;
+    header.vertex_count = vertex_count;
+    header.index_count = index_count;
+    header.vertex_offset = align_to(sizeof(header), 16);
+    header.index_offset = align_to(header.vertex_offset + vertex_count * vertex_size, 16);
+    header.bbox_offset = align_to(header.index_offset + index_count * sizeof(unsigned short), 16);
+    unsigned int corner_size = mesh_vertex_size(vertex_type & MESH_POSITION_BITS);
+    header.file_size = align_to(header.bbox_offset + 8 * corner_size, 16);
+    memcpy(header.position_scale, position_scale, sizeof(position_scale));
+    memcpy(header.position_offset, position_offset, sizeof(position_offset));
+    memcpy(header.uv_scale, uv_scale, sizeof(uv_scale));
+    memcpy(header.uv_offset, uv_offset, sizeof(uv_offset));
+    header.radius = radius;
+    header.lod_error = lod_error;
+
+    unsigned char *blob = (unsigned char *)calloc(header.file_size, 1);
+    memcpy(blob, &header, sizeof(header));
+    memcpy(blob + header.index_offset, indices, index_count * sizeof(unsigned short));
+
+    float position_error = 0.0f, uv_error = 0.0f;
+    for (unsigned int i = 0; i < vertex_count; i++)
+    {
+        unsigned char *vertex = blob + header.vertex_offset + i * vertex_size;
+        unsigned int v = order[i];
+
+        if (options->texture != MESH_NONE)
+        {
+            float one = fraction_one(options->texture);
+            for (int a = 0; a < 2; a++)
+            {
+                float uv = source->uv ? source->uv[v * 2 + a] : 0.0f;
+                float stored = (uv - uv_offset[a]) / uv_scale[a] * one;
+                if (options->texture != MESH_FLOAT)
+                {
+                    stored = fminf(fmaxf(roundf(stored), 0.0f), largest_unsigned(options->texture));
+                    uv_error = fmaxf(uv_error, fabsf(uv_offset[a] + stored / one * uv_scale[a] - uv));
+                }
+                put_value(vertex + layout.texture + a * (options->texture == MESH_FLOAT ? 4 : options->texture), options->texture, stored);
+            }
+        }
+
+        if (options->color != MESH_COLOR_NONE)
+        {
+            static const float white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+            unsigned int packed = pack_color(source->color ? source->color + v * 4 : white, options->color);
+            if (options->color == MESH_COLOR_8888)
+                memcpy(vertex + layout.color, &packed, 4);
+            else
+            {
+                unsigned short half = packed;
+                memcpy(vertex + layout.color, &half, 2);
+            }
+        }
+
+        if (options->normal != MESH_NONE)
+        {
+            unsigned int bytes = options->normal == MESH_FLOAT ? 4 : options->normal;
+            for (int a = 0; a < 3; a++)
+            {
+                float n = source->normal ? source->normal[v * 3 + a] : (a == 2 ? 1.0f : 0.0f);
+                float stored = options->normal == MESH_FLOAT ? n : roundf(fminf(fmaxf(n, -1.0f), 1.0f) * largest_signed(options->normal));
+                put_value(vertex + layout.normal + a * bytes, options->normal, stored);
+            }
+        }
+
+        unsigned int bytes = options->position == MESH_FLOAT ? 4 : options->position;
+        for (int a = 0; a < 3; a++)
+        {
+            float p = source->position[v * 3 + a];
+            float one = fraction_one(options->position);
+            float stored = (p - position_offset[a]) / position_scale[a] * one;
+            if (options->position != MESH_FLOAT)
+            {
+                float limit = largest_signed(options->position);
+                stored = fminf(fmaxf(roundf(stored), -limit), limit);
+                position_error = fmaxf(position_error, fabsf(position_offset[a] + stored / one * position_scale[a] - p));
+            }
+            put_value(vertex + layout.position + a * bytes, options->position, stored);
+        }
+    }
+
+    // the bounding box, rounded outwards so the quantized box still holds every vertex
+    for (int corner = 0; corner < 8; corner++)
+    {
+        unsigned int bytes = options->position == MESH_FLOAT ? 4 : options->position;
+        for (int a = 0; a < 3; a++)
+        {
+            int top = (corner >> a) & 1;
+            float p = top ? high[a] : low[a];
+            float stored = (p - position_offset[a]) / position_scale[a] * fraction_one(options->position);
+            if (options->position != MESH_FLOAT)
+            {
+                float limit = largest_signed(options->position);
+                stored = fminf(fmaxf(top ? ceilf(stored) : floorf(stored), -limit), limit);
+            }
+            put_value(blob + header.bbox_offset + corner * corner_size + a * bytes, options->position, stored);
+        }
+    }
+
+    *level = (struct Level){blob, header.file_size, vertex_count, index_count, triangles, prim, position_error, uv_error, lod_error};
+    if (indices != list)
+        free(indices);
+    free(list);
+    free(remap);
+    free(order);
+}
+
+// ---- level of detail
+
+struct Cell
+{
+    unsigned int key, vertex;
+};
+
+static int cell_compare(const void *left, const void *right)
+{
+    unsigned int a = ((const struct Cell *)left)->key, b = ((const struct Cell *)right)->key;
+    return a < b ? -1 : a > b;
+}
+
+// vertex clustering: the box of the mesh is cut in cubes, `cells` along its longest side, and every
+// vertex is replaced by the vertex of its cube nearest to the cube average, so the kept vertices keep
+// their texture coordinates and colors. triangles that lose a corner that way are dropped. writes the
+// triangles of the simplified mesh to indices (vertices of source) and returns their index count,
+// error is how far a vertex moved at most
+static unsigned int cluster(const struct Source *source, unsigned int cells, unsigned int *indices, float *error)
+{
+    float low[3], high[3], side = 0.0f;
+    for (int a = 0; a < 3; a++)
+    {
+        low[a] = high[a] = source->position[a];
+        for (unsigned int i = 1; i < source->vertex_count; i++)
+        {
+            low[a] = fminf(low[a], source->position[i * 3 + a]);
+            high[a] = fmaxf(high[a], source->position[i * 3 + a]);
+        }
+        side = fmaxf(side, high[a] - low[a]);
+    }
+    float cube = side > 0.0f ? side / cells : 1.0f;
+
+    // the vertices sorted by cube
+    struct Cell *sorted = (struct Cell *)malloc(source->vertex_count * sizeof(struct Cell));
+    for (unsigned int i = 0; i < source->vertex_count; i++)
+    {
+        unsigned int key = 0;
+        for (int a = 2; a >= 0; a--)
+        {
+            unsigned int c = (unsigned int)((source->position[i * 3 + a] - low[a]) / cube);
+            key = key * (cells + 1) + (c > cells ? cells : c);
+        }
+        sorted[i] = (struct Cell){key, i};
+    }
+    qsort(sorted, source->vertex_count, sizeof(struct Cell), cell_compare);
+
+    unsigned int *kept = (unsigned int *)malloc(source->vertex_count * sizeof(unsigned int));
+    *error = 0.0f;
+    for (unsigned int first = 0, last; first < source->vertex_count; first = last)
+    {
+        float average[3] = {0.0f, 0.0f, 0.0f};
+        for (last = first; last < source->vertex_count && sorted[last].key == sorted[first].key; last++)
+            for (int a = 0; a < 3; a++)
+                average[a] += source->position[sorted[last].vertex * 3 + a];
+
+        unsigned int best = sorted[first].vertex;
+        float best_distance = INFINITY;
+        for (unsigned int i = first; i < last; i++)
+        {
+            const float *p = source->position + sorted[i].vertex * 3;
+            float d = 0.0f;
+            for (int a = 0; a < 3; a++)
+                d += (p[a] - average[a] / (last - first)) * (p[a] - average[a] / (last - first));
+            if (d < best_distance)
+            {
+                best = sorted[i].vertex;
+                best_distance = d;
+            }
+        }
+
+        const float *b = source->position + best * 3;
+        for (unsigned int i = first; i < last; i++)
+        {
+            const float *p = source->position + sorted[i].vertex * 3;
+            kept[sorted[i].vertex] = best;
+            *error = fmaxf(*error, sqrtf((p[0] - b[0]) * (p[0] - b[0]) + (p[1] - b[1]) * (p[1] - b[1]) + (p[2] - b[2]) * (p[2] - b[2])));
+        }
+    }
+
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < source->index_count; i += 3)
+    {
+        unsigned int a = kept[source->indices[i]], b = kept[source->indices[i + 1]], c = kept[source->indices[i + 2]];
+        if (a == b || b == c || c == a)
+            continue;
+        indices[count++] = a;
+        indices[count++] = b;
+        indices[count++] = c;
+    }
+
+    free(sorted);
+    free(kept);
+    return count;
+}
+
+// the finest clustering with at most target triangles, found by bisecting the cube count. returns
+// the index count (0 when even that is not possible)
+static unsigned int simplify(const struct Source *source, unsigned int target, unsigned int *indices, float *error)
+{
+    unsigned int low = 1, high = 1024, best = 0;
+    while (low <= high)
+    {
+        unsigned int cells = (low + high) / 2;
+        float e;
+        if (cluster(source, cells, indices, &e) / 3 <= target)
+        {
+            best = cells;
+            low = cells + 1;
+        }
+        else
+        {
+            high = cells - 1;
+        }
+    }
+    return best ? cluster(source, best, indices, error) : 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <model.obj|.gltf|.glb> <model.mesh> [--texture none|8|16|float] [--color none|5650|5551|4444|8888]\n"
+                        "       [--normal none|8|16|float] [--position 8|16|float] [--list] [--lod 1..%d]\n",
+                argv[0], MESH_MAX_LODS);
+        return 1;
+    }
+
+    struct Source source = {0};
+    int loaded = ends_with(argv[1], ".obj") ? load_obj(argv[1], &source) : load_gltf(argv[1], &source);
+    if (loaded < 0)
+        return 1;
+    if (source.vertex_count == 0 || source.index_count == 0)
+    {
+        fprintf(stderr, "%s: no triangles\n", argv[1]);
+        return 1;
+    }
+    if (source.vertex_count > MAX_VERTICES)
+    {
+        fprintf(stderr, "%s: %u vertices, the GE indexes at most %u, split the model\n", argv[1], source.vertex_count, MAX_VERTICES);
+        return 1;
+    }
+
+    struct Options options = {source.uv ? MESH_16BIT : MESH_NONE, source.color ? MESH_COLOR_8888 : MESH_COLOR_NONE, MESH_NONE, MESH_16BIT, 1};
+    int lods = 1;
+    for (int i = 3; i < argc; i++)
+    {
+        int ok = 1;
+        if (strcmp(argv[i], "--list") == 0)
+            options.strip = 0;
+        else if (strcmp(argv[i], "--texture") == 0 && i + 1 < argc)
+            ok = (options.texture = parse_component(argv[++i], 1)) >= 0;
+        else if (strcmp(argv[i], "--color") == 0 && i + 1 < argc)
+            ok = (options.color = parse_color(argv[++i])) >= 0;
+        else if (strcmp(argv[i], "--normal") == 0 && i + 1 < argc)
+            ok = (options.normal = parse_component(argv[++i], 1)) >= 0;
+        else if (strcmp(argv[i], "--position") == 0 && i + 1 < argc)
+            ok = (options.position = parse_component(argv[++i], 0)) >= 0;
+        else if (strcmp(argv[i], "--lod") == 0 && i + 1 < argc)
+            ok = (lods = atoi(argv[++i])) >= 1 && lods <= MESH_MAX_LODS;
+        else
+            ok = 0;
+        if (!ok)
+        {
+            fprintf(stderr, "bad option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    // level 0 is the model, every next level has at most half the triangles of the one before.
+    // the chain stops early when the mesh does not get any simpler
+    struct Level levels[MESH_MAX_LODS];
+    unsigned int level_count = 0;
+    encode(&source, &options, 0.0f, &levels[level_count++]);
+
+    unsigned int *simplified = (unsigned int *)malloc(source.index_count * sizeof(unsigned int));
+    struct Source coarse = source;
+    coarse.indices = simplified;
+    while ((int)level_count < lods)
+    {
+        float error;
+        unsigned int target = levels[level_count - 1].triangles / 2;
+        unsigned int index_count = target ? simplify(&source, target, simplified, &error) : 0;
+        if (index_count == 0)
+            break;
+        // a coarser level is never reported closer to the model than the one before, mesh_lod_select relies on it
+        coarse.index_count = index_count;
+        error = fmaxf(error, levels[level_count - 1].lod_error);
+        encode(&coarse, &options, error, &levels[level_count++]);
+    }
+
+    FILE *out = fopen(argv[2], "wb");
+    if (out == NULL)
+    {
+        fprintf(stderr, "cannot create %s\n", argv[2]);
+        return 1;
+    }
+    int ok = 1;
+    unsigned int file_size = 0;
+    for (unsigned int i = 0; i < level_count; i++)
+    {
+        ok = ok && fwrite(levels[i].blob, levels[i].size, 1, out) == 1;
+        file_size += levels[i].size;
+    }
+    ok = fclose(out) == 0 && ok;
+    if (!ok)
+    {
+        fprintf(stderr, "failed to write %s\n", argv[2]);
+        return 1;
+    }
+
+    // read back the way the game does
+    struct MeshLod lod;
+    if (mesh_lod_load(argv[2], &lod) < 0 || lod.count != level_count)
+    {
+        fprintf(stderr, "%s: mesh_lod_load refuses the file\n", argv[2]);
+        return 1;
+    }
+
+    // what the model takes as the usual float vertices drawn as a list, no indices
+    struct Options floats = {options.texture ? MESH_FLOAT : MESH_NONE, options.color ? MESH_COLOR_8888 : MESH_COLOR_NONE,
+                             options.normal ? MESH_FLOAT : MESH_NONE, MESH_FLOAT, 0};
+    unsigned int float_list = levels[0].triangles * 3 * layout_of(&floats).size;
+
+    printf("%s: %u bytes, %u level%s (float triangle list %u bytes), loaded in %u us\n", argv[2], file_size, level_count,
+           level_count > 1 ? "s" : "", float_list, lod.levels[0].load_us);
+    for (unsigned int i = 0; i < level_count; i++)
+    {
+        const struct Level *level = &levels[i];
+        printf("    lod %u: %u vertices x %u bytes, %u indices (%s, %u triangles), %u bytes, lod error %g, position error %g, texture error %g\n",
+               i, level->vertex_count, lod.levels[i].header->vertex_size, level->index_count, level->prim == MESH_STRIP ? "strip" : "list",
+               level->triangles, level->size, level->lod_error, level->position_error, level->uv_error);
+    }
+
+    mesh_lod_destroy(&lod);
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Host benchmark of the level pack decoder
+//
+// build and run from psp_loadrunner/ with your host compiler:
+//     gcc -O2 -o pack_bench tools/pack_bench.c tilegrid.c level.c
+//     ./pack_bench levels/levels.lrp
+//
+// every level of the pack is decoded in place many times, the same way levelpack_load does it.
+// the PSP numbers are printed by the game on every level switch
+
+#include "../headers/level.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ITERATIONS (20000)
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "levels/levels.lrp";
+
+    struct LevelPack pack;
+    if (levelpack_open(path, &pack) < 0)
+    {
+        printf("cannot open %s\n", path);
+        return 1;
+    }
+
+    double total_time = 0.0;
+    double total_cells = 0.0;
+
+    for (unsigned int n = 0; n < pack.level_count; n++)
+    {
+        struct TileGrid grid;
+        if (levelpack_load(&pack, n, &grid) < 0)
+        {
+            printf("level %u failed to load\n", n);
+            return 1;
+        }
+
+        const struct PackEntry *entry = &pack.index[n];
+        unsigned int cell_count = grid.width * grid.height;
+
+        // keep the encoded bytes around, decoding in place destroys them
+        unsigned char *packed = (unsigned char *)malloc(entry->packed_size);
+        unsigned char *cells = (unsigned char *)malloc(cell_count);
+
+        fseek(pack.file, entry->offset, SEEK_SET);
+        if (fread(packed, 1, entry->packed_size, pack.file) != entry->packed_size)
+            return 1;
+
+        double start = now_seconds();
+        for (int i = 0; i < ITERATIONS; i++)
+        {
+            memcpy(cells + cell_count - entry->packed_size, packed, entry->packed_size);
+            level_rle_decode(cells, cell_count, cells + cell_count - entry->packed_size, entry->packed_size);
+        }
+        double time = now_seconds() - start;
+
+        if (memcmp(cells, grid.cells, cell_count) != 0)
+        {
+            printf("level %u decoded differently\n", n);
+            return 1;
+        }
+
+        printf("level %u: %u -> %u bytes, %.0f ns per decode, %.1f MB/s\n", n, entry->packed_size, cell_count,
+               time / ITERATIONS * 1e9, cell_count * (double)ITERATIONS / time / 1e6);
+
+        total_time += time;
+        total_cells += (double)cell_count * ITERATIONS;
+
+        free(packed);
+        free(cells);
+        tilegrid_destroy(&grid);
+    }
+
+    printf("overall: %.1f MB/s of decoded cells (includes copying the encoded bytes in place)\n", total_cells / total_time / 1e6);
+    levelpack_close(&pack);
+    return 0;
+}
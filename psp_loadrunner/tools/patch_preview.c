@@ -0,0 +1,108 @@
+// Host preview of the GE tessellated patches (patch.h)
+//
+// build from psp_loadrunner/ with your host compiler:
+//     gcc -O2 -o patch_preview tools/patch_preview.c patch.c -lm
+//     ./patch_preview preview.obj [divide]
+//
+// tessellates the HUD panel and a spline terrain the way the GE does, with divide segments per span
+// (default 4), and writes them as a Wavefront .obj any model viewer opens. it prints what the CPU
+// builds and the bus carries (control points) against what the GE makes of them (triangles), and
+// checks that the panel does not fold over itself
+
+#include "../headers/patch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TERRAIN_SIDE (8)
+
+// writes the tessellated grid of a patch as quads of 2 triangles, returns how many of them face the wrong way
+static unsigned int write_patch(FILE *out, const struct Patch *patch, const char *name, unsigned int *first_vertex)
+{
+    unsigned int columns = patch_spans(patch, 0) * patch->divide_u;
+    unsigned int rows = patch_spans(patch, 1) * patch->divide_v;
+    struct PatchVertex *grid = (struct PatchVertex *)malloc((columns + 1) * (rows + 1) * sizeof(struct PatchVertex));
+    if (grid == NULL)
+        return 0;
+    patch_tessellate(patch, grid);
+
+    fprintf(out, "o %s\n", name);
+    for (unsigned int i = 0; i < (columns + 1) * (rows + 1); i++)
+        fprintf(out, "v %f %f %f\n", grid[i].x, grid[i].y, grid[i].z);
+
+    unsigned int folded = 0;
+    for (unsigned int j = 0; j < rows; j++)
+    {
+        for (unsigned int i = 0; i < columns; i++)
+        {
+            unsigned int a = j * (columns + 1) + i, b = a + 1, c = a + columns + 1, d = c + 1;
+            fprintf(out, "f %u %u %u\n", *first_vertex + a, *first_vertex + b, *first_vertex + d);
+            fprintf(out, "f %u %u %u\n", *first_vertex + a, *first_vertex + d, *first_vertex + c);
+
+            // the panel is flat and faces +z, every cell has to keep the orientation of the grid
+            float area = (grid[b].x - grid[a].x) * (grid[c].y - grid[a].y) - (grid[b].y - grid[a].y) * (grid[c].x - grid[a].x);
+            folded += area <= 0.0f;
+        }
+    }
+    *first_vertex += (columns + 1) * (rows + 1);
+
+    unsigned int points = patch->ucount * patch->vcount;
+    printf("%-8s %3u control points (%5u bytes) -> %5u triangles (%6u bytes as a triangle list)\n", name, points,
+           points * (unsigned int)sizeof(struct PatchVertex), patch_triangles(patch),
+           patch_triangles(patch) * 3 * (unsigned int)sizeof(struct PatchVertex));
+
+    free(grid);
+    return folded;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s preview.obj [divide]\n", argv[0]);
+        return 1;
+    }
+    int divide = argc > 2 ? atoi(argv[2]) : 4;
+    if (divide < 1 || divide > 64)
+    {
+        fprintf(stderr, "divide has to be 1 .. 64\n");
+        return 1;
+    }
+
+    FILE *out = fopen(argv[1], "w");
+    if (out == NULL)
+    {
+        fprintf(stderr, "cannot create %s\n", argv[1]);
+        return 1;
+    }
+
+    // the HUD panel of layers.c
+    static struct PatchVertex panel_points[PATCH_PANEL_SIDE * PATCH_PANEL_SIDE];
+    struct Patch panel;
+    patch_rounded_panel(&panel, panel_points, 0.0f, 0.0f, 3.5f, 0.3f, 0.08f, 0xFF000000);
+    panel.divide_u = panel.divide_v = divide;
+
+    // a rolling height field, open on both sides so it continues smoothly past its points
+    static struct PatchVertex terrain_points[TERRAIN_SIDE * TERRAIN_SIDE];
+    for (int j = 0; j < TERRAIN_SIDE; j++)
+    {
+        for (int i = 0; i < TERRAIN_SIDE; i++)
+        {
+            float height = ((i * 7 + j * 13) % 5) * 0.1f;
+            terrain_points[j * TERRAIN_SIDE + i] = (struct PatchVertex){(float)i, (float)j, 0xFF000000, (float)i, (float)j + 2.0f, height};
+        }
+    }
+    struct Patch terrain = {terrain_points, TERRAIN_SIDE, TERRAIN_SIDE, PATCH_SPLINE, PATCH_OPEN_OPEN, PATCH_OPEN_OPEN,
+                            divide, divide, PATCH_SURFACE};
+
+    unsigned int first_vertex = 1;
+    unsigned int folded = write_patch(out, &panel, "panel", &first_vertex);
+    write_patch(out, &terrain, "terrain", &first_vertex);
+    fclose(out);
+
+    // the rounded corners have to end on the outline: left middle and bottom middle of the panel
+    struct PatchVertex corner;
+    patch_evaluate(&panel, 0.0f, 0.0f, &corner);
+    printf("panel corner at (%.4f, %.4f), folded cells: %u\n", corner.x, corner.y, folded);
+    return folded ? 1 : 0;
+}
@@ -0,0 +1,203 @@
+// GE skinning and morphing (skin.h) against CPU skinning, at several bone counts
+//
+// on the host only the CPU path runs, build and run from psp_loadrunner/ with your host compiler:
+//     gcc -O2 -o skin_bench tools/skin_bench.c skin.c -lm
+//     ./skin_bench
+//
+// on the PSP both paths are timed to the end of their display list. build it as an ELF and start it with psplink:
+//     PSPSDK=$(psp-config --pspsdk-path)
+//     psp-gcc -D__PSP__ -O2 -G0 -I$PSPSDK/include -L$PSPSDK/lib -o skin_bench.elf
+//         tools/skin_bench.c skin.c matrix.c -lm -lpspgu -lpspge -lpspdisplay -lpspdebug -lpspuser -lpspkernel
+//     ./skin_bench.elf
+//
+// the mesh is a strip of quads bent by a chain of bones, every vertex weighted between its two
+// nearest bones. the identity pose has to give back the rest positions
+
+#include "../headers/skin.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __PSP__
+#include "../headers/matrix.h"
+
+#include <pspdisplay.h>
+#include <pspgu.h>
+#include <pspkernel.h>
+
+PSP_MODULE_INFO("skin_bench", 0, 1, 1);
+PSP_MAIN_THREAD_ATTR(THREAD_ATTR_USER | THREAD_ATTR_VFPU);
+
+static unsigned int __attribute__((aligned(16))) list[262144];
+
+static double now_seconds()
+{
+    return sceKernelGetSystemTimeLow() / 1e6;
+}
+
+// just enough of initGraphics to run draws, nothing is looked at
+static void init_gu()
+{
+    sceGuInit();
+    sceGuStart(GU_DIRECT, list);
+    sceGuDrawBuffer(GU_PSM_8888, (void *)0, 512);
+    sceGuDispBuffer(480, 272, (void *)0x88000, 512);
+    sceGuOffset(2048 - 240, 2048 - 136);
+    sceGuViewport(2048, 2048, 480, 272);
+    sceGuEnable(GU_SCISSOR_TEST);
+    sceGuScissor(0, 0, 480, 272);
+    sceGuDisable(GU_DEPTH_TEST);
+    sceGuDisable(GU_TEXTURE_2D);
+    sceGuFinish();
+    sceGuSync(0, 0);
+    sceGuDisplay(GU_TRUE);
+
+    matrix_init();
+    matrix_mode(GU_PROJECTION);
+    matrix_ortho(-16.0f / 9.0f, 16.0f / 9.0f, -1.0f, 1.0f, -10.0f, 10.0f);
+}
+#else
+#include <time.h>
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+#endif
+
+#define SEGMENTS (1024) // quads along the strip
+#define VERTICES ((SEGMENTS + 1) * 2)
+#define REPEAT (50)
+
+static int build_mesh(struct SkinMesh *mesh, unsigned int bones, unsigned int morphs)
+{
+    if (skin_mesh_create(mesh, bones, morphs, VERTICES, SEGMENTS * 6) < 0)
+        return -1;
+
+    for (unsigned int i = 0; i <= SEGMENTS; i++)
+    {
+        // where along the bone chain this pair of vertices sits
+        float along = (float)i / SEGMENTS * (bones - 1);
+        unsigned int bone = (unsigned int)along;
+        float blend = along - bone;
+
+        float weights[SKIN_MAX_BONES] = {0.0f};
+        weights[bone] = 1.0f - blend;
+        if (bone + 1 < bones)
+            weights[bone + 1] = blend;
+
+        float x = -1.5f + 3.0f * i / SEGMENTS;
+        for (unsigned int m = 0; m < morphs; m++)
+        {
+            float thickness = 0.05f + 0.05f * m; // every target is a fatter strip
+            skin_set_vertex(mesh, i * 2 + 0, m, weights, (float)i / SEGMENTS, 0.0f, x, -thickness, 0.0f);
+            skin_set_vertex(mesh, i * 2 + 1, m, weights, (float)i / SEGMENTS, 1.0f, x, thickness, 0.0f);
+        }
+    }
+
+    for (unsigned int i = 0; i < SEGMENTS; i++)
+    {
+        unsigned short *q = mesh->indices + i * 6;
+        unsigned short v = i * 2;
+        q[0] = v, q[1] = v + 1, q[2] = v + 3;
+        q[3] = v + 3, q[4] = v + 2, q[5] = v;
+    }
+
+    skin_mesh_flush(mesh);
+    return 0;
+}
+
+// every bone turned a little more than the one before, the targets mixed evenly
+static void bend_pose(struct SkinPose *pose, float angle, unsigned int morphs)
+{
+    skin_pose_identity(pose);
+    for (int b = 0; b < SKIN_MAX_BONES; b++)
+    {
+        float c = cosf(angle * b), s = sinf(angle * b);
+        float *m = pose->bones[b];
+        m[0] = c, m[1] = s, m[4] = -s, m[5] = c;
+    }
+    for (unsigned int m = 0; m < morphs; m++)
+        pose->morph[m] = 1.0f / morphs;
+}
+
+int main()
+{
+#ifdef __PSP__
+    init_gu();
+#endif
+
+    static struct BatchVertex __attribute__((aligned(16))) skinned[VERTICES];
+    const unsigned int bone_counts[] = {1, 2, 4, 8};
+
+    for (unsigned int morphs = 1; morphs <= 2; morphs++)
+    {
+        for (unsigned int c = 0; c < sizeof(bone_counts) / sizeof(bone_counts[0]); c++)
+        {
+            unsigned int bones = bone_counts[c];
+            struct SkinMesh mesh;
+            if (build_mesh(&mesh, bones, morphs) < 0)
+            {
+                printf("out of memory\n");
+                return 1;
+            }
+
+            // the identity pose gives back the rest positions of the first target
+            struct SkinPose pose;
+            skin_pose_identity(&pose);
+            skin_cpu(&mesh, &pose, skinned);
+            float error = 0.0f;
+            for (unsigned int i = 0; i < VERTICES; i++)
+            {
+                float expected_y = (i & 1 ? 1.0f : -1.0f) * 0.05f;
+                float e = fabsf(skinned[i].y - expected_y);
+                error = e > error ? e : error;
+            }
+
+            bend_pose(&pose, 0.1f, morphs);
+
+            double start = now_seconds();
+            for (int r = 0; r < REPEAT; r++)
+                skin_cpu(&mesh, &pose, skinned);
+            double cpu = (now_seconds() - start) / REPEAT;
+
+            printf("%u bones, %u targets: cpu skinning %7.1f us per %u vertices", bones, morphs, cpu * 1e6, VERTICES);
+
+#ifdef __PSP__
+            // GE: bone matrices and morph weights go in the list, the GE blends every vertex
+            start = now_seconds();
+            sceGuStart(GU_DIRECT, list);
+            for (int r = 0; r < REPEAT; r++)
+                skin_draw(&mesh, &pose);
+            sceGuFinish();
+            sceGuSync(0, 0);
+            double ge = (now_seconds() - start) / REPEAT;
+
+            // CPU: skinning, writeback and a plain draw of the result
+            start = now_seconds();
+            sceGuStart(GU_DIRECT, list);
+            for (int r = 0; r < REPEAT; r++)
+            {
+                skin_cpu(&mesh, &pose, skinned);
+                sceKernelDcacheWritebackRange(skinned, sizeof(skinned));
+                batch_vertex_draw3d(GU_TRIANGLES, mesh.index_count, mesh.indices, skinned);
+            }
+            sceGuFinish();
+            sceGuSync(0, 0);
+            double cpu_draw = (now_seconds() - start) / REPEAT;
+
+            printf(", ge draw %7.1f us, cpu skinning + draw %7.1f us", ge * 1e6, cpu_draw * 1e6);
+#endif
+            printf(", rest pose error %g\n", error);
+            skin_mesh_destroy(&mesh);
+        }
+    }
+
+#ifdef __PSP__
+    sceKernelExitGame();
+#endif
+    return 0;
+}
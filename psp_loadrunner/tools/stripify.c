@@ -0,0 +1,227 @@
+// Host stripifier, turns an indexed triangle list into one joined triangle strip (see headers/strip.h)
+//
+// build from psp_loadrunner/ with your host compiler:
+//     gcc -O2 -o stripify tools/stripify.c strip.c
+//     ./stripify mesh.txt mesh_strip.h name    writes the strip of mesh.txt as a C array called name
+//     ./stripify --grid 32 16                  strips a 32x16 quad grid and prints the savings
+//
+// the input is the indices of the triangles as text, 3 per triangle, separated by spaces, commas or
+// new lines (a C initializer list pastes as is). every strip is checked to draw exactly the triangles
+// of its list with the same winding before it is written
+
+#include "../headers/strip.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_INDICES (65535 * 3)
+
+// a triangle rotated so its smallest index comes first, which keeps the winding
+static void canonical(unsigned short *t)
+{
+    while (t[0] > t[1] || t[0] > t[2])
+    {
+        unsigned short first = t[0];
+        t[0] = t[1];
+        t[1] = t[2];
+        t[2] = first;
+    }
+}
+
+static int triangle_compare(const void *left, const void *right)
+{
+    return memcmp(left, right, 3 * sizeof(unsigned short)) < 0 ? -1 : memcmp(left, right, 3 * sizeof(unsigned short)) > 0;
+}
+
+// the triangles a strip draws, the way the GE reads it
+static unsigned int unpack_strip(const unsigned short *strip, unsigned int length, unsigned short *out)
+{
+    unsigned int triangles = 0;
+    for (unsigned int i = 0; i + 2 < length; i++)
+    {
+        unsigned short a = strip[i], b = strip[i + 1], c = strip[i + 2];
+        if (a == b || b == c || c == a)
+            continue;
+
+        unsigned short *t = out + triangles * 3;
+        t[0] = i & 1 ? b : a;
+        t[1] = i & 1 ? a : b;
+        t[2] = c;
+        triangles++;
+    }
+    return triangles;
+}
+
+// 0 when the strip draws the same triangles as the list
+static int check_strip(const unsigned short *indices, unsigned int triangles, const unsigned short *strip, unsigned int length)
+{
+    unsigned short *expected = (unsigned short *)malloc(triangles * 3 * sizeof(unsigned short));
+    unsigned short *drawn = (unsigned short *)malloc(length * 3 * sizeof(unsigned short));
+    if (expected == NULL || drawn == NULL)
+    {
+        free(expected);
+        free(drawn);
+        return -1;
+    }
+
+    unsigned int kept = 0;
+    for (unsigned int i = 0; i < triangles; i++)
+    {
+        const unsigned short *t = indices + i * 3;
+        if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0])
+            continue;
+        memcpy(expected + kept * 3, t, 3 * sizeof(unsigned short));
+        canonical(expected + kept * 3);
+        kept++;
+    }
+
+    unsigned int count = unpack_strip(strip, length, drawn);
+    for (unsigned int i = 0; i < count; i++)
+        canonical(drawn + i * 3);
+
+    qsort(expected, kept, 3 * sizeof(unsigned short), triangle_compare);
+    qsort(drawn, count, 3 * sizeof(unsigned short), triangle_compare);
+
+    int result = count == kept && memcmp(expected, drawn, kept * 3 * sizeof(unsigned short)) == 0 ? 0 : -1;
+    free(expected);
+    free(drawn);
+    return result;
+}
+
+// strips the list and checks it, returns the strip length or -1
+static int build_checked(const unsigned short *indices, unsigned int triangles, unsigned short *strip)
+{
+    int length = strip_build(indices, triangles, strip);
+    if (length < 0)
+    {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    if (check_strip(indices, triangles, strip, length) < 0)
+    {
+        fprintf(stderr, "the strip does not match the triangle list\n");
+        return -1;
+    }
+    return length;
+}
+
+// a width x height grid of quads sharing their corners, 2 triangles per quad in the order of square_indices
+static int grid(unsigned int width, unsigned int height)
+{
+    unsigned int triangles = width * height * 2;
+    if ((width + 1) * (height + 1) > 65536 || triangles * 3 > MAX_INDICES)
+    {
+        fprintf(stderr, "grid too big for 16 bit indices\n");
+        return 1;
+    }
+
+    unsigned short *indices = (unsigned short *)malloc(triangles * 3 * sizeof(unsigned short));
+    unsigned short *strip = (unsigned short *)malloc(STRIP_MAX_INDICES(triangles) * sizeof(unsigned short));
+    if (indices == NULL || strip == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    unsigned short *t = indices;
+    for (unsigned int y = 0; y < height; y++)
+    {
+        for (unsigned int x = 0; x < width; x++)
+        {
+            unsigned short bottom_left = y * (width + 1) + x;
+            unsigned short top_left = bottom_left + width + 1;
+            unsigned short quad[6] = {bottom_left, top_left, top_left + 1, top_left + 1, bottom_left + 1, bottom_left};
+            memcpy(t, quad, sizeof(quad));
+            t += 6;
+        }
+    }
+
+    int length = build_checked(indices, triangles, strip);
+    if (length < 0)
+        return 1;
+
+    printf("%ux%u grid: %u triangles, list %u indices, strip %d indices (%.2fx fewer vertices transformed)\n",
+           width, height, triangles, triangles * 3, length, (double)(triangles * 3) / length);
+
+    free(indices);
+    free(strip);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 4 && strcmp(argv[1], "--grid") == 0)
+        return grid(atoi(argv[2]), atoi(argv[3]));
+
+    if (argc != 4)
+    {
+        fprintf(stderr, "usage: %s mesh.txt out.h name\n       %s --grid width height\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    FILE *in = fopen(argv[1], "r");
+    if (in == NULL)
+    {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    static unsigned short indices[MAX_INDICES];
+    unsigned int count = 0;
+    int c;
+    long value = -1;
+    while ((c = fgetc(in)) != EOF)
+    {
+        if (c >= '0' && c <= '9')
+        {
+            value = (value < 0 ? 0 : value * 10) + (c - '0');
+            continue;
+        }
+        if (value >= 0)
+        {
+            if (value > 65535 || count == MAX_INDICES)
+            {
+                fprintf(stderr, "index %ld out of range or too many indices\n", value);
+                fclose(in);
+                return 1;
+            }
+            indices[count++] = value;
+            value = -1;
+        }
+    }
+    if (value >= 0 && count < MAX_INDICES)
+        indices[count++] = value;
+    fclose(in);
+
+    if (count % 3 != 0)
+    {
+        fprintf(stderr, "%u indices is not a whole number of triangles\n", count);
+        return 1;
+    }
+
+    unsigned int triangles = count / 3;
+    unsigned short *strip = (unsigned short *)malloc(STRIP_MAX_INDICES(triangles) * sizeof(unsigned short) + 1);
+    int length = build_checked(indices, triangles, strip);
+    if (length < 0)
+        return 1;
+
+    FILE *out = fopen(argv[2], "w");
+    if (out == NULL)
+    {
+        fprintf(stderr, "cannot create %s\n", argv[2]);
+        return 1;
+    }
+
+    fprintf(out, "// %u triangles as one strip, made by tools/stripify.c from %s. draw it with GU_TRIANGLE_STRIP\n", triangles, argv[1]);
+    fprintf(out, "#define %s_COUNT (%d)\n", argv[3], length);
+    fprintf(out, "unsigned short __attribute__((aligned(16))) %s[%d] = {", argv[3], length);
+    for (int i = 0; i < length; i++)
+        fprintf(out, "%s%s%u", i ? "," : "", i % 16 ? " " : "\n    ", strip[i]);
+    fprintf(out, "};\n");
+    fclose(out);
+
+    printf("%u triangles: list %u indices, strip %d indices\n", triangles, count, length);
+    free(strip);
+    return 0;
+}